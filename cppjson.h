@@ -62,7 +62,24 @@ USAGE:
 #include <cstddef>
 #include <cstdint>
 
+#include <string_view>
 #include <tuple>
+#include <type_traits>
+
+#ifndef CPPJSON_NO_THREADS
+#    include <atomic>
+#    include <condition_variable>
+#    include <mutex>
+#    include <thread>
+#endif // CPPJSON_NO_THREADS
+
+#ifndef CPPJSON_NO_BIND
+#    include <limits>
+#    include <optional>
+#    include <string>
+#    include <utility>
+#    include <vector>
+#endif // CPPJSON_NO_BIND
 
 namespace cppjson
 {
@@ -76,11 +93,105 @@ namespace cppjson
 
 typedef void* (*CPPJSON_MALLOC_TYPE)(size_t);
 typedef void (*CPPJSON_FREE_TYPE)(void*);
+typedef void* (*CPPJSON_REALLOC_TYPE)(void*, size_t);
+
+/**
+ * @brief Memory functions with a user context, which is passed to each function
+ *
+ * A zero initialized allocator means malloc, free and realloc.
+ */
+struct JsonAllocator
+{
+    void* (*allocate_)(void* context, size_t size); //!< allocate memory aligned to 16 bytes, or return null
+    void (*deallocate_)(void* context, void* ptr); //!< deallocate memory, the ptr can be null
+    void* (*reallocate_)(void* context, void* ptr, size_t size, size_t new_size); //!< optional, resize memory of the size bytes
+    void* context_; //!< the context
+};
+
+/**
+ * @brief Memory functions without a context, which JsonAllocator calls
+ */
+struct JsonFunctions
+{
+    CPPJSON_MALLOC_TYPE alloc_; //!< allocator
+    CPPJSON_FREE_TYPE dealloc_; //!< deallocator
+    CPPJSON_REALLOC_TYPE realloc_; //!< reallocator
+};
+
+#ifdef CPPJSON_COMPACT
+typedef uint32_t JsonSize; //!< the type of positions and sizes in a document, define CPPJSON_COMPACT for documents under 4 GB
+#else
+typedef uint64_t JsonSize; //!< the type of positions and sizes in a document, define CPPJSON_COMPACT for documents under 4 GB
+#endif
 
 #ifndef CPPJSON_ASSERT
 #    define CPPJSON_ASSERT(exp) assert(exp)
 #endif // CPPJSON_ASSERT
 
+#ifndef CPPJSON_NO_BIND
+/**
+ * @brief Declare members of a structure to bind, at the namespace of the structure
+ *
+ * ```cpp
+ * struct User
+ * {
+ *     int64_t id;
+ *     std::string name;
+ * };
+ * CPPJSON_BIND(User, id, name)
+ * ```
+ * Up to 32 members, and the names of members are the keys.
+ */
+#    define CPPJSON_BIND(TYPE, ...) \
+        inline constexpr auto cppjson_fields(const TYPE*) \
+        { \
+            return std::make_tuple(CPPJSON_EXPAND(CPPJSON_CONCAT(CPPJSON_FIELDS_, CPPJSON_COUNT(__VA_ARGS__))(TYPE, __VA_ARGS__))); \
+        }
+
+#    define CPPJSON_EXPAND(x) x
+#    define CPPJSON_CONCAT(x, y) CPPJSON_CONCAT_(x, y)
+#    define CPPJSON_CONCAT_(x, y) x##y
+#    define CPPJSON_COUNT(...) CPPJSON_EXPAND(CPPJSON_COUNT_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#    define CPPJSON_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#    define CPPJSON_FIELD(TYPE, NAME) \
+        ::cppjson::JsonField<TYPE, decltype(TYPE::NAME)> \
+        { \
+            #NAME, &TYPE::NAME \
+        }
+#    define CPPJSON_FIELDS_1(TYPE, NAME) CPPJSON_FIELD(TYPE, NAME)
+#    define CPPJSON_FIELDS_2(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_1(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_3(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_2(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_4(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_3(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_5(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_4(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_6(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_5(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_7(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_6(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_8(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_7(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_9(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_8(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_10(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_9(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_11(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_10(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_12(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_11(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_13(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_12(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_14(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_13(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_15(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_14(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_16(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_15(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_17(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_16(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_18(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_17(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_19(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_18(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_20(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_19(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_21(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_20(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_22(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_21(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_23(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_22(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_24(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_23(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_25(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_24(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_26(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_25(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_27(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_26(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_28(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_27(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_29(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_28(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_30(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_29(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_31(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_30(TYPE, __VA_ARGS__))
+#    define CPPJSON_FIELDS_32(TYPE, NAME, ...) CPPJSON_FIELD(TYPE, NAME), CPPJSON_EXPAND(CPPJSON_FIELDS_31(TYPE, __VA_ARGS__))
+#endif // CPPJSON_NO_BIND
+
 /**
  * @brief types
  */
@@ -101,13 +212,68 @@ enum class JsonType
 
 /**
  * @brief value type
+ *
+ * Elements are stored in document order, so the descendants of an aggregation are laid out contiguously after it.
+ * An aggregation's next_ holds the end of its descendants, and an entry's next_ holds the next sibling entry.
+ * The size is 24 bytes, or 16 bytes with CPPJSON_COMPACT.
  */
+class JsonReader;
+
 struct JsonValue
 {
-    uint64_t start_; //!< the start position of element
-    uint64_t size_; //!< the size of element
-    uint32_t next_; //!< the next element of aggretations
-    uint32_t type_; //!< the type of element
+    static constexpr uint32_t Decoded = 0x01U; //!< the number is decoded
+    static constexpr uint32_t UInt64 = 0x02U; //!< the integer is out of range of int64, but in range of uint64
+    static constexpr uint32_t Overflow = 0x04U; //!< the integer is out of range of both int64 and uint64
+    static constexpr uint32_t Indexed = 0x08U; //!< the aggregation has a table of children, the first key's next_ of an object or the first entry's start_ of an array holds its position
+    static constexpr uint32_t Escaped = 0x10U; //!< the string has escapes
+
+    JsonSize start_; //!< the start position of element
+    JsonSize size_; //!< the size of element
+    uint32_t next_; //!< the next entry of aggretations, the end of descendants of an aggregation, or the decoded value of a number
+    uint32_t type_ : 8; //!< the type of element
+    uint32_t flags_ : 24; //!< the flags of element
+};
+
+/**
+ * @brief decoded value of a number
+ */
+union JsonNumber
+{
+    int64_t int64_;
+    uint64_t uint64_;
+    double float64_;
+};
+
+/**
+ * @brief reasons of errors
+ */
+enum class JsonError
+{
+    None = 0,
+    UnexpectedEnd, //!< the document ends in a value
+    UnexpectedCharacter, //!< a character which the grammar does not allow
+    InvalidString, //!< a control character in a string
+    InvalidEscape, //!< an unknown escape, or a malformed `\u` escape
+    InvalidUtf8, //!< a malformed UTF-8 sequence in a string
+    InvalidNumber, //!< a malformed number
+    InvalidLiteral, //!< a malformed true, false or null
+    TooDeep, //!< the nesting exceeds the memory for open objects or arrays
+    TooLarge, //!< the document exceeds JsonReader::MaxSize
+    NoMemory, //!< the allocation failed
+};
+
+/**
+ * @brief result of validation
+ */
+struct JsonStatus
+{
+    /**
+     * @return true if the document is valid
+     */
+    operator bool() const;
+
+    JsonError error_; //!< the reason of the first error, or None
+    uint64_t offset_; //!< the position of the first error from the begin of the document
 };
 
 /**
@@ -143,7 +309,7 @@ struct JsonProxy
     JsonProxy begin() const;
 
     /**
-     * @return the next element of aggrations
+     * @return the next element of aggrations, which skips whole descendants of this entry
      */
     JsonProxy next() const;
 
@@ -158,820 +324,7643 @@ struct JsonProxy
 
     /**
      * @brief Get the value as string
-     * @param [out] str ... the result
+     *
+     * The raw string in the document is copied, so escapes are kept.
+     * @param [out] str ... the result, which must have size() + 1 bytes
      * @return size of the result
      */
     uint64_t getString(char* str) const;
 
+    /**
+     * @brief Get the value as string with escapes decoded
+     *
+     * Escapes are decoded into UTF-8, surrogate pairs of `\u` escapes are combined, and lone surrogates become U+FFFD.
+     * Strings without escapes are just copied. The result is truncated to capacity - 1 bytes and terminated by a null.
+     * @param [out] str ... the result, can be null if capacity is 0
+     * @param capacity ... the bytes of str
+     * @return size of the decoded string, which is not truncated, so the result fits if it is less than capacity
+     */
+    uint64_t getString(char* str, uint64_t capacity) const;
+
+    /**
+     * @brief Get the raw string in the document without copying
+     * @return the raw string, which equals to the value if isEscaped is false
+     */
+    std::string_view getStringView() const;
+
+    /**
+     * @return true if the string has escapes, which is recorded by parse
+     */
+    bool isEscaped() const;
+
     /**
      * @brief Get the value as integer
      * @return the value as integer
      */
     int64_t getInt64() const;
+    /**
+     * @brief Get the value as unsigned integer
+     * @return the value as unsigned integer
+     */
+    uint64_t getUInt64() const;
     /**
      * @brief Get the value as float
      * @return the value as float
      */
     double getFloat64() const;
 
+    /**
+     * @return true if the integer is larger than the maximum of int64, and fits in uint64
+     */
+    bool isUInt64() const;
+    /**
+     * @return true if the integer fits in neither int64 nor uint64
+     */
+    bool isOverflow() const;
+
+    /**
+     * @brief Compare the key of an object's entry
+     * @param str ... the key, which is compared with the raw string in the document
+     * @return true if the key equals to str
+     */
     bool compareKey(const char* str) const;
 
+    /**
+     * @brief Find a member of an object
+     *
+     * Small objects are searched linearly. Objects with more members than JsonReader::IndexThreshold
+     * build a hash index of keys on the first lookup, and the index is reused until the next parse.
+     * Building the index modifies the reader, so call JsonReader::buildTables before lookups from several threads.
+     * @param key ... the key, which is compared with the raw string in the document
+     * @return the value of the member, or an invalid element if not found
+     */
+    JsonProxy find(std::string_view key) const;
+
+    /**
+     * @return the number of children of an object or array, zero for others
+     */
+    uint64_t count() const;
+
+    /**
+     * @brief Get an element of an array
+     *
+     * Small arrays are walked linearly. Arrays with more elements than JsonReader::IndexThreshold
+     * build a table of elements on the first access, and the table is reused until the next parse.
+     * Building the table modifies the reader, so call JsonReader::buildTables before accesses from several threads.
+     * @param index
+     * @return the element, or an invalid element if out of range
+     */
+    JsonProxy at(uint64_t index) const;
+
     uint64_t value_;
     const char* data_;
     const JsonValue* values_;
+    const JsonNumber* numbers_;
+    const JsonReader* reader_;
 };
 
 /**
- * @brief parser of a Json document
+ * @brief Json element navigated on demand
+ *
+ * A cursor is a position in the document, and parses forward only as far as the navigation needs.
+ * Subtrees which are passed over by next, find or at are skipped by counting brackets outside of strings, 64 bytes at a time.
+ * No elements are stored, so the memory is just the cursors held by the caller.
+ * Only visited elements are validated, see JsonReader::cursor.
  */
-class JsonReader
+struct JsonCursor
 {
-public:
-    static constexpr uint32_t Invalid = static_cast<uint32_t>(-1); //!< Invalid value as uint32_t
-    static constexpr std::tuple<const char*, uint32_t> InvalidPair = {CPPJSON_NULL, Invalid}; //!< Invalid value of the pair of next and value
-    static constexpr uint32_t Expand = 128; //!< the expansion of buffer's capacity
-    static constexpr int32_t MaxNesting = 128; //!< the maximum of nesting for objects or arrays
+    /**
+     * @brief validate this element
+     * @return true if this is valid
+     */
+    operator bool() const;
 
     /**
-     * @param max_nesting ... the maximum of nesting for objects or arrays
-     * @param alloc ... the function for memory allocation
-     * @param dealloc ... the furnction for memory deallocation
-     * @warning the alloc and dealloc must be passed simultaneously
+     * @return type of this
      */
-    JsonReader(int32_t max_nesting = MaxNesting, CPPJSON_MALLOC_TYPE alloc = CPPJSON_NULL, CPPJSON_FREE_TYPE dealloc = CPPJSON_NULL);
-    ~JsonReader();
+    JsonType type() const;
 
     /**
-     * @param begin
-     * @param end
-     * @return
-     * @pre begin != null
-     * @pre end != null
-     * @pre begin<=end
+     * Indicates the size of element. The length of a string excepts characters `"`, and the number of children of an aggregation.
+     * @return size of this
      */
-    bool parse(const char* begin, const char* end);
-    JsonProxy root() const;
-private:
-    JsonReader(const JsonReader&) = delete;
-    JsonReader& operator=(const JsonReader&) = delete;
+    uint64_t size() const;
 
-    uint32_t add();
-    void add_value(uint32_t set, uint32_t value);
+    /**
+     * @return the first entry of an object or array
+     */
+    JsonCursor begin() const;
 
-    const char* whitespace(const char* str);
-    const char* parse_utf8(const char* str);
-    const char* parse_element(const char* str);
-    std::tuple<const char*, uint32_t> parse_value(const char* str);
-    std::tuple<const char*, uint32_t> parse_string(const char* str);
-    const char* parse_4hex(const char* str);
-    const char* parse_zero_number(JsonType& type, const char* str);
-    const char* parse_number(JsonType& type, const char* str);
-    const char* parse_fraction(const char* str);
-    const char* parse_exponent(const char* str);
-    const char* parse_digits(const char* str);
-    std::tuple<const char*, uint32_t> parse_object(const char* str);
-    std::tuple<const char*, uint32_t> parse_member(const char* str);
-    std::tuple<const char*, uint32_t> parse_array(const char* str);
-    std::tuple<const char*, uint32_t> parse_array_value(const char* str);
-    const char* parse_true(const char* str);
-    const char* parse_false(const char* str);
-    const char* parse_null(const char* str);
+    /**
+     * @return the next entry, which skips the value of this entry
+     */
+    JsonCursor next() const;
 
-    CPPJSON_MALLOC_TYPE alloc_; //!< allocator
-    CPPJSON_FREE_TYPE dealloc_; //!< deallocator
-    const char* begin_; //!< begin of document
-    const char* end_; //!< end of document
-    int32_t max_nesting_; //!< the maximum of nesting
-    int32_t nesting_; //!< current nesting
+    /**
+     * @return key of an object's entry
+     */
+    JsonCursor key() const;
+    /**
+     * @return value of an object's or array's entry
+     */
+    JsonCursor value() const;
 
-    uint32_t capacity_; //!< capacity of buffer
-    uint32_t size_; //!< current size of buffer
-    JsonValue* values_; //!< elements of Json
-};
-} // namespace cppjson
+    /**
+     * @brief Get the value as string
+     * @param [out] str ... the result
+     * @return size of the result
+     */
+    uint64_t getString(char* str) const;
 
-#endif // INC_CPPJSON_H_
+    /**
+     * @brief Get the value as integer
+     * @return the value as integer
+     */
+    int64_t getInt64() const;
+    /**
+     * @brief Get the value as unsigned integer
+     * @return the value as unsigned integer
+     */
+    uint64_t getUInt64() const;
+    /**
+     * @brief Get the value as float
+     * @return the value as float
+     */
+    double getFloat64() const;
 
-#ifdef CPPJSON_IMPLEMENTATION
-#include <charconv>
-#include <cstdlib>
-#include <cstring>
+    /**
+     * @brief Compare the key of an object's entry
+     * @param str ... the key, which is compared with the raw string in the document
+     * @return true if the key equals to str
+     */
+    bool compareKey(std::string_view str) const;
 
-namespace cppjson
-{
+    /**
+     * @brief Find a member of an object by walking its entries
+     * @param key ... the key, which is compared with the raw string in the document
+     * @return the value of the member, or an invalid element if not found
+     */
+    JsonCursor find(std::string_view key) const;
 
-JsonProxy::operator bool() const
-{
-    return JsonReader::Invalid != value_;
-}
+    /**
+     * @return the number of children of an object or array, zero for others or malformed ones
+     */
+    uint64_t count() const;
 
-JsonType JsonProxy::type() const
-{
-    if(JsonReader::Invalid != value_) {
-        return static_cast<JsonType>(values_[value_].type_);
-    }
-    return JsonType::Invalid;
-}
+    /**
+     * @brief Get an element of an array by walking its entries
+     * @param index
+     * @return the element, or an invalid element if out of range
+     */
+    JsonCursor at(uint64_t index) const;
 
-uint64_t JsonProxy::size() const
-{
-    CPPJSON_ASSERT(JsonReader::Invalid != value_);
-    return values_[value_].size_;
-}
+    const char* str_; //!< the start of element, or the key of an object's entry
+    const char* end_; //!< the end of document
+    JsonType type_; //!< the type of element
+};
 
-JsonProxy JsonProxy::begin() const
+/**
+ * @brief Monotonic memory, which releases all allocations at once
+ *
+ * Allocations are taken from chunks in order, and deallocations are ignored except for the last allocation.
+ * Objects which use this through allocator() must be destroyed before reset.
+ * This is not thread safe.
+ */
+class JsonArena
 {
-    CPPJSON_ASSERT(JsonReader::Invalid != value_);
-    if(static_cast<uint32_t>(JsonType::Object) != values_[value_].type_
-       && static_cast<uint32_t>(JsonType::Array) != values_[value_].type_) {
-        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL};
-    }
-    return {values_[value_].next_, data_, values_};
-}
+public:
+    static constexpr uint64_t ChunkSize = 64 * 1024; //!< the default size of chunks
+    static constexpr uint64_t Align = 16; //!< the alignment of allocations
 
-JsonProxy JsonProxy::next() const
-{
-    CPPJSON_ASSERT(JsonReader::Invalid != value_);
-    return {values_[value_].next_, data_, values_};
-}
+    /**
+     * @param chunk_size ... the minimum size of chunks taken from the functions
+     * @param alloc ... the function for memory allocation
+     * @param dealloc ... the furnction for memory deallocation
+     * @warning the alloc and dealloc must be passed simultaneously
+     */
+    explicit JsonArena(uint64_t chunk_size = ChunkSize, CPPJSON_MALLOC_TYPE alloc = CPPJSON_NULL, CPPJSON_FREE_TYPE dealloc = CPPJSON_NULL);
+    ~JsonArena();
 
-JsonProxy JsonProxy::key() const
-{
-    CPPJSON_ASSERT(JsonReader::Invalid != value_);
-    if(JsonType::KeyValue != type()) {
-        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL};
-    }
-    return {values_[value_].start_, data_, values_};
-}
+    /**
+     * @return the memory functions which allocate from this
+     */
+    JsonAllocator allocator();
 
-JsonProxy JsonProxy::value() const
-{
-    CPPJSON_ASSERT(JsonReader::Invalid != value_);
-    if(JsonType::KeyValue != type() && JsonType::ArrayValue != type()) {
-        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL};
-    }
-    return {values_[value_].size_, data_, values_};
-}
+    /**
+     * @brief Allocate memory
+     * @param size
+     * @return the memory aligned to Align, or null if the allocation failed
+     */
+    void* allocate(size_t size);
 
-uint64_t JsonProxy::getString(char* str) const
-{
-    ::memcpy(str, data_ + values_[value_].start_, values_[value_].size_);
-    str[values_[value_].size_] = '\0';
-    return values_[value_].size_;
-}
+    /**
+     * @brief Deallocate memory, only the last allocation is given back
+     * @param ptr
+     */
+    void deallocate(void* ptr);
 
-int64_t JsonProxy::getInt64() const
-{
-    const char* first = data_ + values_[value_].start_;
-    const char* last = first + values_[value_].size_;
-    int64_t value = 0;
-    std::from_chars(first, last, value);
-    return value;
-}
+    /**
+     * @brief Resize memory, the last allocation grows in place
+     * @param ptr ... the memory or null
+     * @param size ... the size of the memory
+     * @param new_size
+     * @return the memory, or null if the allocation failed
+     */
+    void* reallocate(void* ptr, size_t size, size_t new_size);
 
-double JsonProxy::getFloat64() const
-{
-    const char* first = data_ + values_[value_].start_;
-#if _MSC_VER
-    const char* last = first + values_[value_].size_;
-    double value = 0;
-    std::from_chars(first, last, value);
-#else
-    char buffer[127];
-    uint64_t size = values_[value_].size_ < 128ULL ? values_[value_].size_ : 127ULL;
-    ::memcpy(buffer, first, size);
-    buffer[size] = '\0';
-    double value = strtod(buffer, CPPJSON_NULL);
-#endif
-    return value;
-}
+    /**
+     * @brief Release all allocations, chunks are merged into one to be reused
+     * @return false if the merged chunk cannot be allocated, then all chunks are released
+     */
+    bool reset();
 
-bool JsonProxy::compareKey(const char* str) const
+    /**
+     * @brief Release all allocations and chunks
+     */
+    void release();
+
+    /**
+     * @return the allocated bytes since the last reset
+     */
+    uint64_t size() const;
+
+    /**
+     * @return the bytes of chunks
+     */
+    uint64_t capacity() const;
+
+private:
+    /**
+     * @brief The header of chunks
+     */
+    struct Chunk
+    {
+        Chunk* next_; //!< the previous chunk
+        uint64_t capacity_; //!< the bytes after the header
+    };
+
+    JsonArena(const JsonArena&) = delete;
+    JsonArena& operator=(const JsonArena&) = delete;
+
+    bool expand(uint64_t size);
+
+    CPPJSON_MALLOC_TYPE alloc_; //!< allocator
+    CPPJSON_FREE_TYPE dealloc_; //!< deallocator
+    uint64_t chunk_size_; //!< the minimum size of chunks
+    uint64_t size_; //!< the allocated bytes, excluding the rest of chunks
+    uint64_t capacity_; //!< the bytes of chunks
+    Chunk* chunks_; //!< the current chunk
+    char* top_; //!< the next allocation
+    char* end_; //!< the end of the current chunk
+    char* last_; //!< the last allocation, or null
+};
+
+/**
+ * @brief Pooled memory in classes of powers of two, which keeps deallocated blocks for the next allocations
+ *
+ * Each block has a header of Align bytes. Blocks larger than the largest class are not kept.
+ * This is not thread safe, use a pool for each thread.
+ */
+class JsonPool
+{
+public:
+    static constexpr uint64_t MinSize = 64; //!< the size of the smallest class including the header
+    static constexpr uint32_t Classes = 32; //!< the number of classes
+    static constexpr uint64_t Align = 16; //!< the alignment of allocations
+
+    /**
+     * @param alloc ... the function for memory allocation
+     * @param dealloc ... the furnction for memory deallocation
+     * @warning the alloc and dealloc must be passed simultaneously
+     */
+    explicit JsonPool(CPPJSON_MALLOC_TYPE alloc = CPPJSON_NULL, CPPJSON_FREE_TYPE dealloc = CPPJSON_NULL);
+
+    /**
+     * @brief Release kept blocks, blocks in use are not released
+     */
+    ~JsonPool();
+
+    /**
+     * @return the memory functions which allocate from this
+     */
+    JsonAllocator allocator();
+
+    /**
+     * @brief Allocate memory
+     * @param size
+     * @return the memory aligned to Align, or null if the allocation failed
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief Deallocate memory, which is kept for the next allocations of the same class
+     * @param ptr
+     */
+    void deallocate(void* ptr);
+
+    /**
+     * @brief Resize memory, which stays if the new size is in the same class
+     * @param ptr ... the memory or null
+     * @param size ... the size of the memory
+     * @param new_size
+     * @return the memory, or null if the allocation failed
+     */
+    void* reallocate(void* ptr, size_t size, size_t new_size);
+
+    /**
+     * @brief Release kept blocks
+     */
+    void trim();
+
+    /**
+     * @return the bytes of kept blocks
+     */
+    uint64_t cached() const;
+
+private:
+    /**
+     * @brief The header of blocks
+     */
+    struct Block
+    {
+        Block* next_; //!< the next kept block
+        uint64_t class_; //!< the class, or Classes if not kept
+    };
+
+    JsonPool(const JsonPool&) = delete;
+    JsonPool& operator=(const JsonPool&) = delete;
+
+    static uint32_t classify(uint64_t size);
+
+    CPPJSON_MALLOC_TYPE alloc_; //!< allocator
+    CPPJSON_FREE_TYPE dealloc_; //!< deallocator
+    uint64_t cached_; //!< the bytes of kept blocks
+    Block* blocks_[Classes]; //!< kept blocks of each class
+};
+
+/**
+ * @brief compiled set of paths, which are evaluated by JsonReader::parse
+ *
+ * Paths are JSON Pointers like `/user/id`, or dot paths like `user.id`, and a token `*` matches all members or elements.
+ * The tokens of all paths are merged into a trie, so that each path is compiled once and evaluated against many documents.
+ */
+class JsonQuery
+{
+public:
+    static constexpr uint32_t Invalid = static_cast<uint32_t>(-1); //!< Invalid value as uint32_t
+
+    /**
+     * @param alloc ... the function for memory allocation
+     * @param dealloc ... the furnction for memory deallocation
+     * @param realloc ... the function for memory reallocation, optional
+     * @warning the alloc and dealloc must be passed simultaneously
+     */
+    JsonQuery(CPPJSON_MALLOC_TYPE alloc = CPPJSON_NULL, CPPJSON_FREE_TYPE dealloc = CPPJSON_NULL, CPPJSON_REALLOC_TYPE realloc = CPPJSON_NULL);
+
+    /**
+     * @param allocator ... the memory functions
+     */
+    explicit JsonQuery(const JsonAllocator& allocator);
+    ~JsonQuery();
+
+    /**
+     * @brief Add a path
+     *
+     * A path which starts with `/` is a JSON Pointer, `~0` and `~1` in its tokens are replaced with `~` and `/`.
+     * Others are dot paths separated by `.` without escapes. An empty path is the root.
+     * Tokens are compared with the raw keys in documents, and decimal tokens also match the elements of arrays.
+     * @param path
+     * @return the index of the path, which is the same for the same path, or Invalid if the path is malformed or the allocation failed
+     */
+    uint32_t add(std::string_view path);
+
+    /**
+     * @return the number of paths
+     */
+    uint32_t size() const;
+
+    /**
+     * @brief Remove all paths
+     */
+    void clear();
+
+private:
+    friend class JsonReader;
+
+    /**
+     * @brief A token of paths
+     */
+    struct Node
+    {
+        uint32_t token_; //!< the position of the token
+        uint32_t token_size_; //!< the size of the token
+        uint32_t index_; //!< the index of arrays which the token matches, or Invalid
+        uint32_t child_; //!< the first child
+        uint32_t sibling_; //!< the next sibling
+        uint32_t path_; //!< the path which ends at this, or Invalid
+        bool wildcard_; //!< whether this matches all members or elements
+    };
+
+    JsonQuery(const JsonFunctions& functions, const JsonAllocator& allocator);
+    JsonQuery(const JsonQuery&) = delete;
+    JsonQuery& operator=(const JsonQuery&) = delete;
+
+    void* allocate(size_t size) const;
+    void deallocate(void* ptr) const;
+    void* reallocate(void* ptr, size_t size, size_t new_size) const;
+    uint32_t insert(uint32_t parent, const char* token, uint64_t size, bool wildcard);
+    bool matches(uint32_t node, const char* key, uint64_t size) const;
+
+    JsonFunctions functions_; //!< the functions without a context
+    JsonAllocator allocator_; //!< the memory functions
+    uint32_t paths_; //!< the number of paths
+    uint32_t node_capacity_; //!< capacity of nodes
+    uint32_t node_size_; //!< size of nodes, the first is the root
+    Node* nodes_; //!< nodes of the trie
+    uint32_t token_capacity_; //!< capacity of tokens
+    uint32_t token_size_; //!< size of tokens
+    char* tokens_; //!< unescaped tokens
+};
+
+/**
+ * @brief parser of a Json document
+ */
+class JsonReader
+{
+public:
+    static constexpr uint32_t Invalid = static_cast<uint32_t>(-1); //!< Invalid value as uint32_t
+    static constexpr std::tuple<const char*, uint32_t> InvalidPair = {CPPJSON_NULL, Invalid}; //!< Invalid value of the pair of next and value
+    static constexpr uint32_t Expand = 128; //!< the minimum expansion of buffer's capacity
+    static constexpr uint32_t Growth = 100; //!< the default expansion of buffer's capacity in percent of the current capacity
+    static constexpr int32_t MaxNesting = 128; //!< the maximum of nesting for objects or arrays, which are parsed recursively
+    static constexpr uint64_t StackBudget = 1024 * 1024; //!< the default memory for open objects or arrays in bytes, see setStackBudget
+    static constexpr uint64_t MaxSize = static_cast<JsonSize>(-1); //!< the maximum size of a document
+    static constexpr uint64_t ParallelThreshold = 1024 * 1024; //!< documents smaller than this are parsed by one thread
+    static constexpr uint32_t IndexThreshold = 16; //!< objects or arrays with more children than this are accessed with a table built on the first access
+    static constexpr uint32_t IndexVersion = 3; //!< the version of the layout of saved elements, increased when JsonValue or the header changes
+
+    /**
+     * @param max_nesting ... the maximum of nesting for objects or arrays, which are parsed recursively, see setStackBudget
+     * @param alloc ... the function for memory allocation
+     * @param dealloc ... the furnction for memory deallocation
+     * @param realloc ... the function for memory reallocation, optional
+     * @warning the alloc and dealloc must be passed simultaneously
+     */
+    JsonReader(int32_t max_nesting = MaxNesting, CPPJSON_MALLOC_TYPE alloc = CPPJSON_NULL, CPPJSON_FREE_TYPE dealloc = CPPJSON_NULL, CPPJSON_REALLOC_TYPE realloc = CPPJSON_NULL);
+
+    /**
+     * @param max_nesting ... the maximum of nesting for objects or arrays, which are parsed recursively, see setStackBudget
+     * @param allocator ... the memory functions for elements and all other buffers
+     * @warning parseParallel calls the allocator from several threads
+     */
+    JsonReader(int32_t max_nesting, const JsonAllocator& allocator);
+    ~JsonReader();
+
+    /**
+     * @brief Set the growth policy of the buffer
+     * @param expand ... the minimum number of elements added by an expansion
+     * @param percent ... the number of elements added by an expansion in percent of the current capacity, 0 means linear growth
+     */
+    void setGrowth(uint32_t expand, uint32_t percent);
+
+    /**
+     * @brief Set the memory for open objects or arrays
+     *
+     * Objects and arrays are parsed with a stack allocated by the allocator, so the nesting is limited by this budget,
+     * 12 bytes for each nesting. Streams keep open objects and arrays on the same stack, and accept the same nesting as parse.
+     * Objects and arrays on the paths of projections, queries and binding are walked recursively, which are limited by max_nesting.
+     * @param bytes
+     */
+    void setStackBudget(uint64_t bytes);
+
+    /**
+     * @brief Reserve the buffer for elements
+     *
+     * Elements loaded by loadIndex are released.
+     * @param capacity ... the number of elements
+     * @return false if the allocation failed
+     */
+    bool reserve(uint64_t capacity);
+
+    /**
+     * @return capacity of the buffer
+     */
+    uint32_t capacity() const;
+
+    /**
+     * @brief Release buffers which are larger than the limit
+     *
+     * The current document is discarded, and the released buffers grow again on the next parse.
+     * @param bytes ... the maximum size of each buffer to keep, 0 releases all buffers
+     */
+    void shrink(uint64_t bytes);
+
+    /**
+     * @return the bytes of buffers kept by this reader, excluding mapped files
+     */
+    uint64_t memory() const;
+
+    /**
+     * @brief Estimate the number of elements of a document by counting structural characters
+     *
+     * The result is an upper bound for valid documents, so that
+     * ```cpp
+     * reader.reserve(JsonReader::estimate(begin, end));
+     * ```
+     * makes the parse run with single allocation.
+     * @param begin
+     * @param end
+     * @return the estimated number of elements
+     */
+    static uint64_t estimate(const char* begin, const char* end);
+
+    /**
+     * @brief Enable the structural index
+     *
+     * When it is enabled, parse runs a vectorized first stage which classifies the document 64 bytes at a time,
+     * and records the positions of structural characters, quotes and the starts of other tokens outside strings.
+     * The parser then jumps over whitespaces with the index instead of examining them one by one.
+     * Documents larger than 4 GB are parsed without the index.
+     * @param enable
+     */
+    void setStructuralIndex(bool enable);
+
+    /**
+     * @brief Enable decoding numbers while parsing
+     *
+     * When it is enabled, integers and numbers are decoded once by parse, and getInt64, getUInt64 or getFloat64 just load the results.
+     * Integers out of range of int64 are flagged, see JsonProxy::isUInt64 and JsonProxy::isOverflow.
+     * @param enable
+     */
+    void setNumberDecoding(bool enable);
+
+    /**
+     * @brief Set the fields which parse stores
+     *
+     * Paths of the projection select members of objects by keys and elements of arrays by indices or `*`, see JsonQuery.
+     * Then parse stores only the aggregations on the paths, and the whole values where paths end.
+     * The other members and elements are validated without storing elements, and do not appear in the result.
+     * Scalars where paths go further are dropped too. The projection must outlive the reader, or be reset by null.
+     * @param projection ... the paths to store, or null to store everything
+     */
+    void setProjection(const JsonQuery* projection);
+
+    /**
+     * @param begin
+     * @param end
+     * @return
+     * @pre begin != null
+     * @pre end != null
+     * @pre begin<=end
+     */
+    bool parse(const char* begin, const char* end);
+
+    /**
+     * @brief Parse only the parts of a document which a query needs
+     *
+     * Members and elements which no path can go through are validated and skipped like projections, and no elements are created for them.
+     * Each matched value is parsed into a complete subtree, and the results are listed by matches, match and matchPath in the document order.
+     * Only the matched values are stored, so root returns the first of them.
+     * @param begin
+     * @param end
+     * @param query
+     * @return false if the document is malformed, or the allocation failed
+     * @pre begin != null
+     * @pre end != null
+     * @pre begin<=end
+     */
+    bool parse(const char* begin, const char* end, const JsonQuery& query);
+
+    /**
+     * @brief Validate a document without storing elements
+     *
+     * The grammar is checked by the events of parse with a handler which ignores them, with the structural index if it is enabled, so nothing is stored and root returns an invalid element.
+     * The offset of an error is where the grammar breaks, or the start of the token for numbers and literals.
+     * @param begin
+     * @param end
+     * @return the reason and the offset of the first error
+     * @pre begin != null
+     * @pre end != null
+     * @pre begin<=end
+     */
+    JsonStatus validate(const char* begin, const char* end);
+
+    /**
+     * @brief Parse a document into events of a handler, without storing elements
+     *
+     * The handler's functions are called inline in the document order, and parsing stops when one of them returns false.
+     * ```cpp
+     * struct Handler
+     * {
+     *     bool on_object_begin();
+     *     bool on_object_end(uint64_t members);
+     *     bool on_array_begin();
+     *     bool on_array_end(uint64_t elements);
+     *     bool on_key(std::string_view key);
+     *     bool on_string(std::string_view value);
+     *     bool on_int(int64_t value);
+     *     bool on_uint(uint64_t value); // integers out of range of int64
+     *     bool on_double(double value); // numbers, and integers out of range of uint64
+     *     bool on_bool(bool value);
+     *     bool on_null();
+     * };
+     * ```
+     * Keys and strings are raw as getString, and refer to the document. Nesting is limited by the stack budget, see setStackBudget.
+     * Events before an error have been called, so the handler should discard its result when this returns false.
+     * @param begin
+     * @param end
+     * @param handler
+     * @return false if the document is malformed, a handler's function returned false, or the allocation failed
+     * @pre begin != null
+     * @pre end != null
+     * @pre begin<=end
+     */
+    template<class Handler, class = std::enable_if_t<!std::is_same<std::remove_cv_t<Handler>, JsonQuery>::value>>
+    bool parse(const char* begin, const char* end, Handler& handler);
+
+    /**
+     * @return the number of values which matched paths of the last query
+     */
+    uint64_t matches() const;
+
+    /**
+     * @param index ... the index of a match
+     * @return the value of the match
+     */
+    JsonProxy match(uint64_t index) const;
+
+    /**
+     * @param index ... the index of a match
+     * @return the index of the path in the query
+     */
+    uint32_t matchPath(uint64_t index) const;
+
+    /**
+     * @brief Parse a file without copying it
+     *
+     * A regular file is mapped read-only, and parsed with the sequential access advice.
+     * Other files, like pipes, and files on platforms without mmap are read into a buffer.
+     * The mapping or the buffer is kept until the next parse or the destruction, because elements refer to the file.
+     * @param path
+     * @return false if the file cannot be read or is not a valid document
+     * @pre path != null
+     */
+    bool parseFile(const char* path);
+
+    /**
+     * @brief Save the elements of the current document
+     *
+     * The file has a header with the version, the size and a hash of the document, followed by the elements and the decoded numbers.
+     * Tables for lookups are not saved, those are built again on the first access after loading.
+     * The elements are copied to the file without the tables, so that the reader is not modified.
+     * The layout is of this build, so the file is for the same platform and the same CPPJSON_COMPACT.
+     * @param path
+     * @return false if the file cannot be written, or nothing is parsed
+     * @pre path != null
+     */
+    bool saveIndex(const char* path) const;
+
+    /**
+     * @brief Load the elements of a document saved by saveIndex, instead of parsing the document
+     *
+     * The file is mapped with private writable pages, and the elements are checked in one pass,
+     * so that broken or foreign files do not refer to outside of the document or the elements.
+     * The size and the hash of the whole document are checked against the header, which detects any modification.
+     * Both read the data once, which is much faster than parsing.
+     * On platforms without mmap, the file is read into the buffers.
+     * The mapping is kept until the next parse or the destruction.
+     * @param path ... the saved elements
+     * @param begin ... the document, which must outlive the elements
+     * @param end
+     * @return false if the file cannot be read, or it is not for the document
+     * @pre path != null
+     * @pre begin <= end
+     */
+    bool loadIndex(const char* path, const char* begin, const char* end);
+
+    /**
+     * @brief Load a file and the elements saved by saveIndex for it
+     *
+     * The file is mapped like parseFile, and both are kept until the next parse or the destruction.
+     * @param path ... the document
+     * @param index_path ... the saved elements
+     * @return false if either cannot be read, or the elements are not for the document
+     * @pre path != null
+     * @pre index_path != null
+     */
+    bool loadFile(const char* path, const char* index_path);
+
+#ifndef CPPJSON_NO_THREADS
+    /**
+     * @brief Parse a document with threads
+     *
+     * The elements of the top level array or the members of the top level object are split into pieces at commas,
+     * which are found by a vectorized scan like the structural index. Each thread parses a piece into a separate segment of elements,
+     * then the segments are relocated into one buffer, so that root returns the same tree as parse.
+     * Documents smaller than ParallelThreshold, or not having an aggregation at the top level, are parsed by parse.
+     * @param begin
+     * @param end
+     * @param threads ... the number of threads including the caller's, 0 means the number of hardware threads
+     * @return
+     * @pre begin != null
+     * @pre end != null
+     * @pre begin<=end
+     */
+    bool parseParallel(const char* begin, const char* end, uint32_t threads = 0);
+#endif // CPPJSON_NO_THREADS
+
+#ifndef CPPJSON_NO_BIND
+    /**
+     * @brief Deserialize a document into a value directly
+     *
+     * Types are bound by JsonBind, which supports bool, integers, floating points, std::string, std::string_view,
+     * std::vector, std::optional, and structures declared by CPPJSON_BIND. No elements are stored.
+     * Members of structures are dispatched by a perfect hash of keys built at compile time, and unknown members are validated and skipped.
+     * Members which do not appear in the document are left as they are.
+     * std::string decodes escapes as getString, and std::string_view refers to the raw string in the document.
+     * @param begin
+     * @param end
+     * @param [out] value
+     * @return false if the document is malformed, or does not fit the type
+     * @pre begin != null
+     * @pre end != null
+     * @pre begin<=end
+     */
+    template<class T>
+    bool bind(const char* begin, const char* end, T& value);
+#endif // CPPJSON_NO_BIND
+
+    /**
+     * @brief Begin parsing a document in chunks
+     *
+     * Chunks passed to feed are copied into the buffer owned by this reader, and parsed as far as they are complete.
+     * Containers keep their states across chunks, and a string, a number or a literal which is split by chunks is parsed when its end arrives,
+     * so that the result is identical to the one of parse.
+     * ```cpp
+     * reader.beginStream();
+     * while(receive(chunk)) {
+     *     if(!reader.feed(chunk.begin, chunk.end)) {
+     *         break;
+     *     }
+     * }
+     * bool result = reader.finish();
+     * ```
+     */
+    void beginStream();
+
+    /**
+     * @brief Parse the next chunk of a document
+     * @param begin
+     * @param end
+     * @return false if the document is invalid, or the allocation failed
+     * @pre begin<=end
+     */
+    bool feed(const char* begin, const char* end);
+
+    /**
+     * @brief Finish parsing a document in chunks
+     * @return true if the whole document is valid, then root returns the result
+     */
+    bool finish();
+
+    JsonProxy root() const;
+
+    /**
+     * @brief Build the tables of large objects and arrays for lookups
+     *
+     * JsonProxy::find and JsonProxy::at build the table of an aggregation on the first lookup, which modifies the reader.
+     * After this, lookups do not modify the reader, so that several threads can navigate the document concurrently.
+     * @return false if the allocation failed, then the rest of tables are built on demand
+     */
+    bool buildTables();
+
+    /**
+     * @brief Navigate a document on demand without parsing it
+     *
+     * The result parses forward only as the caller navigates, and builds no elements.
+     * Visited scalars and separators are validated, malformed ones are reported as invalid elements or a zero count, but skipped parts and the rest after the root are not validated.
+     * The document must outlive the cursors.
+     * @param begin
+     * @param end
+     * @return the root element
+     * @pre begin != null
+     * @pre end != null
+     * @pre begin<=end
+     */
+    static JsonCursor cursor(const char* begin, const char* end);
+private:
+    friend struct JsonProxy;
+    friend class JsonLineReader;
+    friend class JsonWriter;
+#ifndef CPPJSON_NO_BIND
+    template<class T, class Enable>
+    friend struct JsonBind;
+
+    typedef uint32_t (*BindFind)(const char* key, uint64_t size);
+    typedef const char* (*BindMember)(JsonReader& reader, const char* str, void* object, uint32_t field);
+    typedef const char* (*BindElement)(JsonReader& reader, const char* str, void* array);
+
+    const char* bind_begin(const char* begin, const char* end);
+    bool bind_end(const char* str);
+    const char* bind_object(const char* str, void* object, BindFind find, BindMember member);
+    const char* bind_array(const char* str, void* array, BindElement element);
+    const char* bind_bool(const char* str, bool& value);
+    const char* bind_int64(const char* str, int64_t& value);
+    const char* bind_uint64(const char* str, uint64_t& value);
+    const char* bind_float64(const char* str, double& value);
+    const char* bind_string(const char* str, const char*& first, uint64_t& size, bool& escaped);
+    static uint64_t bind_unescape(const char* first, uint64_t size, char* out, uint64_t capacity);
+    const char* bind_null(const char* str);
+#endif // CPPJSON_NO_BIND
+
+    /**
+     * @brief The handler of events for validate, which ignores them
+     */
+    struct Validation;
+
+    const char* event_begin(const char* begin, const char* end);
+    bool event_push(const char* str, bool object);
+    const char* event_key(const char* str, std::string_view& key);
+    const char* event_string(const char* str);
+    const char* event_number(const char* str, bool decoding, JsonType& type, uint32_t& flags, JsonNumber& number);
+
+    JsonReader(int32_t max_nesting, const JsonFunctions& functions, const JsonAllocator& allocator);
+    JsonReader(const JsonReader&) = delete;
+    JsonReader& operator=(const JsonReader&) = delete;
+
+    void* allocate(size_t size) const;
+    void deallocate(void* ptr) const;
+    void* reallocate(void* ptr, size_t size, size_t new_size) const;
+    bool expand(uint64_t capacity);
+    uint32_t add();
+    bool index();
+    bool is_plain(uint32_t begin, uint32_t end) const;
+    void add_value(uint32_t set, uint32_t& last, uint32_t value);
+    bool decode(uint32_t value, JsonType type, const char* first, const char* last);
+    bool equals(uint32_t entry, const char* key, uint64_t size) const;
+    uint32_t table(uint64_t size) const;
+    bool hash(uint32_t object) const;
+    uint32_t find(uint32_t object, const char* key, uint64_t size) const;
+    bool tabulate(uint32_t array) const;
+    uint32_t at(uint32_t array, uint64_t index) const;
+
+    /**
+     * @brief What a stream expects next
+     */
+    enum class Expect : uint32_t
+    {
+        Value, //!< a value
+        FirstValue, //!< a value or the end of an array
+        Member, //!< a key
+        FirstMember, //!< a key or the end of an object
+        Colon, //!< a colon after a key
+        Comma, //!< a comma or the end of an aggregation
+        End, //!< the end of a document
+        Error, //!< nothing, the document is invalid
+    };
+
+    /**
+     * @brief An open aggregation of a stream
+     */
+    struct Frame
+    {
+        uint32_t aggregation_; //!< the object or array
+        uint32_t last_; //!< the last entry
+        Expect expect_; //!< what is expected next
+    };
+
+    void clear();
+    void release();
+    char* read_file(const char* path, uint64_t& size, bool& mapped);
+    bool load_index(const char* path, const char* begin, const char* end);
+    static bool check_index(const JsonValue* values, uint32_t size, uint32_t numbers, uint64_t source);
+    uint32_t append(const char* data, const char* begin, const char* end);
+    uint64_t split(const char* open, uint64_t pieces, const char** splits) const;
+    bool parse_entries(const char* data, const char* begin, const char* end, bool object, uint32_t& count, uint32_t& last);
+    bool push_state(uint32_t node);
+    bool resolve(uint32_t value, uint32_t first, uint32_t count);
+    const char* parse_query_value(const char* str, uint32_t first, uint32_t count);
+    void relocate(const JsonReader& segment, uint32_t base, uint32_t number_base);
+    bool push(uint32_t aggregation, Expect expect);
+    bool complete(const char* str, bool last);
+    bool advance(bool last);
+
+    const char* whitespace(const char* str);
+    const char* parse_utf8(const char* str);
+    const char* skip_plain(const char* str);
+    const char* parse_element(const char* str);
+    std::tuple<const char*, uint32_t> parse_value(const char* str);
+    std::tuple<const char*, uint32_t> parse_nested(const char* str);
+    const char* parse_key(const char* str, uint32_t object, uint32_t& last);
+    std::tuple<const char*, uint32_t> parse_string(const char* str);
+    const char* scan_string(const char* str);
+    const char* scan_string(const char* str, bool& escaped);
+    const char* scan_number(JsonType& type, const char* str);
+    const char* parse_4hex(const char* str);
+    const char* parse_zero_number(JsonType& type, const char* str);
+    const char* parse_number(JsonType& type, const char* str);
+    const char* parse_fraction(const char* str);
+    const char* parse_exponent(const char* str);
+    const char* parse_digits(const char* str);
+    std::tuple<const char*, uint32_t> parse_object(const char* str);
+    std::tuple<const char*, uint32_t> parse_member(const char* str);
+    std::tuple<const char*, uint32_t> parse_array(const char* str);
+    std::tuple<const char*, uint32_t> parse_array_value(const char* str);
+    const char* parse_true(const char* str);
+    const char* parse_false(const char* str);
+    const char* parse_null(const char* str);
+    std::tuple<const char*, uint32_t> project(const char* str, bool member, uint32_t index);
+    const char* skip_element(const char* str);
+    const char* skip_key(const char* str);
+    const char* fail(const char* str, JsonError error);
+
+    JsonFunctions functions_; //!< the functions without a context
+    JsonAllocator allocator_; //!< the memory functions
+    const char* begin_; //!< begin of document
+    const char* end_; //!< end of document
+    int32_t max_nesting_; //!< the maximum of nesting
+    int32_t nesting_; //!< current nesting
+    uint64_t stack_budget_; //!< the maximum memory of open aggregations
+
+    uint32_t expand_; //!< the minimum expansion of buffer's capacity
+    uint32_t growth_; //!< the expansion of buffer's capacity in percent
+    uint32_t capacity_; //!< capacity of buffer
+    uint32_t size_; //!< current size of buffer
+    JsonValue* values_; //!< elements of Json
+
+    bool indexing_; //!< whether the structural index is enabled
+    bool indexed_; //!< whether the structural index is built for the current document
+    uint32_t structural_capacity_; //!< capacity of the structural index
+    uint32_t structural_size_; //!< size of the structural index
+    uint32_t structural_; //!< the current position in the structural index
+    uint32_t* structurals_; //!< the positions of structural characters
+    uint64_t special_capacity_; //!< capacity of the special characters
+    uint64_t* specials_; //!< the special characters in strings, one bit per byte
+
+    bool decoding_; //!< whether numbers are decoded while parsing
+    uint32_t number_capacity_; //!< capacity of decoded numbers
+    uint32_t number_size_; //!< size of decoded numbers
+    JsonNumber* numbers_; //!< decoded numbers
+
+    mutable uint32_t table_capacity_; //!< capacity of tables
+    mutable uint32_t table_size_; //!< size of tables
+    mutable uint32_t* tables_; //!< tables of aggregations, hash indices of objects which have the mask followed by the entries, or elements of arrays
+
+    uint64_t stream_capacity_; //!< capacity of the buffer for a stream
+    uint64_t stream_size_; //!< size of the buffer for a stream
+    uint64_t stream_offset_; //!< the position where a stream resumes
+    uint64_t stream_scan_; //!< the position where the search for the end of a string resumes
+    char* stream_; //!< the buffer for a stream
+    Expect expect_; //!< what a stream expects next at the top level
+    uint32_t frame_capacity_; //!< capacity of open aggregations
+    uint32_t frame_size_; //!< size of open aggregations
+    Frame* frames_; //!< open aggregations of a stream
+
+    void* mapping_; //!< the mapped file
+    uint64_t mapping_size_; //!< size of the mapped file
+    char* file_; //!< the buffer of a file which cannot be mapped
+
+    /**
+     * @brief The header of saved elements
+     */
+    struct IndexHeader
+    {
+        char magic_[8]; //!< "CPPJSON" and a null
+        uint32_t version_; //!< IndexVersion
+        uint32_t value_size_; //!< the size of JsonValue
+        uint64_t source_size_; //!< the size of the document
+        uint64_t source_hash_; //!< the hash of the document
+        uint32_t values_; //!< the number of elements
+        uint32_t numbers_; //!< the number of decoded numbers
+        uint32_t flags_; //!< IndexProjected
+        uint32_t reserved_;
+    };
+    static constexpr uint32_t IndexProjected = 0x01U; //!< the elements are filtered by a projection
+    void* index_; //!< the mapped elements
+    uint64_t index_size_; //!< size of the mapped elements
+
+    /**
+     * @brief A value which matched a path of a query
+     */
+    struct Match
+    {
+        uint32_t path_;
+        uint32_t value_;
+    };
+    const JsonQuery* query_; //!< the query of the current parse
+    uint32_t state_capacity_; //!< capacity of states
+    uint32_t state_size_; //!< size of states
+    uint32_t* states_; //!< nodes of the query which match the visited values, stacked by nesting
+    uint32_t match_capacity_; //!< capacity of matches
+    uint32_t match_size_; //!< size of matches
+    Match* matches_; //!< values which matched paths
+
+    const JsonQuery* projection_; //!< the fields to store
+    bool projecting_; //!< whether the current aggregation is filtered by the projection
+    bool projected_; //!< whether the elements of the current document are filtered by the projection
+    uint32_t state_first_; //!< the first state of the current aggregation in the projection
+    uint32_t state_count_; //!< the number of states of the current aggregation in the projection
+
+    JsonError error_; //!< the reason of the first error of validation
+    const char* error_at_; //!< the position of the first error of validation
+};
+
+template<class Handler, class>
+bool JsonReader::parse(const char* begin, const char* end, Handler& handler)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    // Open aggregations are pushed on frames, which count their members or elements in aggregation_
+    // The first error is recorded by fail for validate, whose handler ignores values, so numbers are not decoded for it
+    const bool decoding = !std::is_same<std::remove_cv_t<Handler>, Validation>::value;
+    const char* str = event_begin(begin, end);
+    for(;;) {
+        if(CPPJSON_NULL == str) {
+            return false;
+        }
+        if(end_ <= str) {
+            fail(str, JsonError::UnexpectedEnd);
+            return false;
+        }
+        const char* next = CPPJSON_NULL;
+        bool result = false;
+        switch(str[0]) {
+        case '"':
+            next = event_string(str + 1);
+            result = CPPJSON_NULL != next && handler.on_string(std::string_view(str + 1, static_cast<size_t>(next - str - 1)));
+            next = CPPJSON_NULL != next ? next + 1 : next;
+            break;
+        case '{':
+        case '[': {
+            bool object = '{' == str[0];
+            if(!event_push(str, object) || !(object ? handler.on_object_begin() : handler.on_array_begin())) {
+                return false;
+            }
+            str = whitespace(str + 1);
+            if(str < end_ && (object ? '}' : ']') == str[0]) {
+                --frame_size_;
+                next = str + 1;
+                result = object ? handler.on_object_end(0) : handler.on_array_end(0);
+                break;
+            }
+            if(object) {
+                std::string_view key;
+                str = event_key(str, key);
+                if(CPPJSON_NULL == str || !handler.on_key(key)) {
+                    return false;
+                }
+            }
+            continue;
+        }
+        case 't':
+            next = parse_true(str);
+            next = CPPJSON_NULL != next ? next : fail(str, JsonError::InvalidLiteral);
+            result = CPPJSON_NULL != next && handler.on_bool(true);
+            break;
+        case 'f':
+            next = parse_false(str);
+            next = CPPJSON_NULL != next ? next : fail(str, JsonError::InvalidLiteral);
+            result = CPPJSON_NULL != next && handler.on_bool(false);
+            break;
+        case 'n':
+            next = parse_null(str);
+            next = CPPJSON_NULL != next ? next : fail(str, JsonError::InvalidLiteral);
+            result = CPPJSON_NULL != next && handler.on_null();
+            break;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9': {
+            JsonType type;
+            uint32_t flags;
+            JsonNumber number;
+            next = event_number(str, decoding, type, flags, number);
+            if(CPPJSON_NULL == next) {
+                return false;
+            }
+            if(JsonType::Number == type || 0 != (flags & JsonValue::Overflow)) {
+                result = handler.on_double(number.float64_);
+            } else if(0 != (flags & JsonValue::UInt64)) {
+                result = handler.on_uint(number.uint64_);
+            } else {
+                result = handler.on_int(number.int64_);
+            }
+        } break;
+        default:
+            fail(str, JsonError::UnexpectedCharacter);
+            return false;
+        }
+        if(!result) {
+            return false;
+        }
+        str = next;
+
+        // Close aggregations until the next member or element
+        for(;;) {
+            str = whitespace(str);
+            if(frame_size_ <= 0) {
+                if(str < end_) {
+                    fail(str, JsonError::UnexpectedCharacter);
+                    return false;
+                }
+                return true;
+            }
+            Frame& frame = frames_[frame_size_ - 1];
+            ++frame.aggregation_;
+            if(end_ <= str) {
+                fail(str, JsonError::UnexpectedEnd);
+                return false;
+            }
+            bool object = Expect::Member == frame.expect_;
+            if(',' == str[0]) {
+                str = whitespace(str + 1);
+                if(object) {
+                    std::string_view key;
+                    str = event_key(str, key);
+                    if(CPPJSON_NULL == str || !handler.on_key(key)) {
+                        return false;
+                    }
+                }
+                break;
+            }
+            if((object ? '}' : ']') != str[0]) {
+                fail(str, JsonError::UnexpectedCharacter);
+                return false;
+            }
+            --frame_size_;
+            if(!(object ? handler.on_object_end(frame.aggregation_) : handler.on_array_end(frame.aggregation_))) {
+                return false;
+            }
+            ++str;
+        }
+    }
+}
+
+#ifndef CPPJSON_NO_BIND
+/**
+ * @brief Binding of a type, which reads a value at str and returns the next, or null
+ *
+ * Specialize this to bind other types,
+ * ```cpp
+ * template<>
+ * struct cppjson::JsonBind<Type>
+ * {
+ *     static const char* read(JsonReader& reader, const char* str, Type& value);
+ * };
+ * ```
+ */
+template<class T, class Enable = void>
+struct JsonBind;
+
+/**
+ * @brief A member of a structure declared by CPPJSON_BIND
+ */
+template<class T, class M>
+struct JsonField
+{
+    std::string_view name_;
+    M T::*member_;
+};
+
+/**
+ * @brief Perfect hash of keys
+ */
+struct JsonKeyHash
+{
+    static constexpr uint32_t Invalid = static_cast<uint32_t>(-1); //!< Invalid value as uint32_t
+    static constexpr uint32_t MaxSeed = 1U << 16; //!< the maximum of seeds to search
+
+    /**
+     * @brief FNV-1a hash with a seed
+     */
+    static constexpr uint32_t hash(const char* key, uint64_t size, uint32_t seed)
+    {
+        uint32_t hash = 2166136261U ^ seed;
+        for(uint64_t i = 0; i < size; ++i) {
+            hash = (hash ^ static_cast<uint8_t>(key[i])) * 16777619U;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    /**
+     * @brief Table of slots, which hold the index of a key plus one
+     */
+    template<uint32_t Slots>
+    struct Table
+    {
+        uint32_t seed_;
+        uint8_t slots_[Slots];
+    };
+
+    /**
+     * @brief Search a seed which maps all keys to different slots
+     */
+    template<uint32_t Slots, size_t Size>
+    static constexpr Table<Slots> build(const std::string_view (&keys)[Size])
+    {
+        for(uint32_t seed = 0; seed < MaxSeed; ++seed) {
+            Table<Slots> table{seed, {}};
+            bool perfect = true;
+            for(size_t i = 0; perfect && i < Size; ++i) {
+                uint8_t& slot = table.slots_[hash(keys[i].data(), keys[i].size(), seed) & (Slots - 1)];
+                perfect = 0 == slot;
+                slot = static_cast<uint8_t>(i + 1);
+            }
+            if(perfect) {
+                return table;
+            }
+        }
+        return {Invalid, {}};
+    }
+};
+
+/**
+ * @brief Members of a structure declared by CPPJSON_BIND
+ */
+template<class T>
+struct JsonFields
+{
+    static constexpr auto Fields = cppjson_fields(static_cast<const T*>(CPPJSON_NULL));
+    static constexpr size_t Size = std::tuple_size<decltype(Fields)>::value;
+    static_assert(0 < Size && Size < 255, "the number of members must be in [1, 254]");
+
+    static constexpr uint32_t slots(uint32_t slots = 4)
+    {
+        return (4 * Size) <= slots ? slots : JsonFields::slots(slots * 2);
+    }
+    static constexpr uint32_t Slots = slots();
+
+    template<size_t... I>
+    struct Keys
+    {
+        static constexpr std::string_view Names[Size] = {std::get<I>(Fields).name_...};
+        static constexpr JsonKeyHash::Table<Slots> Table = JsonKeyHash::build<Slots>(Names);
+        static_assert(JsonKeyHash::Invalid != Table.seed_, "the names of members must be distinct");
+
+        static uint32_t find(const char* key, uint64_t size)
+        {
+            uint32_t slot = Table.slots_[JsonKeyHash::hash(key, size, Table.seed_) & (Slots - 1)];
+            if(slot <= 0 || Names[slot - 1] != std::string_view(key, size)) {
+                return JsonKeyHash::Invalid;
+            }
+            return slot - 1;
+        }
+
+        static const char* read(JsonReader& reader, const char* str, void* object, uint32_t field)
+        {
+            typedef const char* (*Read)(JsonReader&, const char*, T&);
+            static constexpr Read Reads[Size] = {&JsonFields::read<I>...};
+            return Reads[field](reader, str, *static_cast<T*>(object));
+        }
+    };
+
+    template<size_t... I>
+    static Keys<I...> keys(std::index_sequence<I...>);
+    typedef decltype(keys(std::make_index_sequence<Size>())) Dispatch;
+
+    template<size_t I>
+    static const char* read(JsonReader& reader, const char* str, T& object)
+    {
+        auto& member = object.*(std::get<I>(Fields).member_);
+        return JsonBind<std::remove_reference_t<decltype(member)>>::read(reader, str, member);
+    }
+};
+
+template<class T>
+struct JsonBind<T, std::void_t<decltype(cppjson_fields(static_cast<const T*>(CPPJSON_NULL)))>>
+{
+    static const char* read(JsonReader& reader, const char* str, T& value)
+    {
+        typedef typename JsonFields<T>::Dispatch Dispatch;
+        return reader.bind_object(str, &value, &Dispatch::find, &Dispatch::read);
+    }
+};
+
+template<>
+struct JsonBind<bool>
+{
+    static const char* read(JsonReader& reader, const char* str, bool& value)
+    {
+        return reader.bind_bool(str, value);
+    }
+};
+
+template<class T>
+struct JsonBind<T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>>
+{
+    static const char* read(JsonReader& reader, const char* str, T& value)
+    {
+        // Integers out of range of the type are errors
+        if(std::is_signed<T>::value) {
+            int64_t x = 0;
+            str = reader.bind_int64(str, x);
+            if(CPPJSON_NULL == str || x < static_cast<int64_t>(std::numeric_limits<T>::min()) || static_cast<int64_t>(std::numeric_limits<T>::max()) < x) {
+                return CPPJSON_NULL;
+            }
+            value = static_cast<T>(x);
+        } else {
+            uint64_t x = 0;
+            str = reader.bind_uint64(str, x);
+            if(CPPJSON_NULL == str || static_cast<uint64_t>(std::numeric_limits<T>::max()) < x) {
+                return CPPJSON_NULL;
+            }
+            value = static_cast<T>(x);
+        }
+        return str;
+    }
+};
+
+template<class T>
+struct JsonBind<T, std::enable_if_t<std::is_floating_point<T>::value>>
+{
+    static const char* read(JsonReader& reader, const char* str, T& value)
+    {
+        double x = 0.0;
+        str = reader.bind_float64(str, x);
+        value = static_cast<T>(x);
+        return str;
+    }
+};
+
+template<>
+struct JsonBind<std::string>
+{
+    static const char* read(JsonReader& reader, const char* str, std::string& value)
+    {
+        const char* first;
+        uint64_t size;
+        bool escaped;
+        str = reader.bind_string(str, first, size, escaped);
+        if(CPPJSON_NULL == str) {
+            return str;
+        }
+        if(escaped) {
+            // Decoded strings are not longer than raw ones
+            value.resize(static_cast<size_t>(size));
+            value.resize(static_cast<size_t>(JsonReader::bind_unescape(first, size, &value[0], size + 1)));
+        } else {
+            value.assign(first, static_cast<size_t>(size));
+        }
+        return str;
+    }
+};
+
+template<>
+struct JsonBind<std::string_view>
+{
+    static const char* read(JsonReader& reader, const char* str, std::string_view& value)
+    {
+        const char* first;
+        uint64_t size;
+        bool escaped;
+        str = reader.bind_string(str, first, size, escaped);
+        if(CPPJSON_NULL != str) {
+            value = std::string_view(first, size);
+        }
+        return str;
+    }
+};
+
+template<class T, class Allocator>
+struct JsonBind<std::vector<T, Allocator>>
+{
+    static const char* read(JsonReader& reader, const char* str, std::vector<T, Allocator>& value)
+    {
+        value.clear();
+        return reader.bind_array(str, &value, &JsonBind::element);
+    }
+
+    static const char* element(JsonReader& reader, const char* str, void* array)
+    {
+        std::vector<T, Allocator>& value = *static_cast<std::vector<T, Allocator>*>(array);
+        value.emplace_back();
+        return JsonBind<T>::read(reader, str, value.back());
+    }
+};
+
+template<class T>
+struct JsonBind<std::optional<T>>
+{
+    static const char* read(JsonReader& reader, const char* str, std::optional<T>& value)
+    {
+        if('n' == str[0]) {
+            value.reset();
+            return reader.bind_null(str);
+        }
+        return JsonBind<T>::read(reader, str, value.emplace());
+    }
+};
+
+template<class T>
+bool JsonReader::bind(const char* begin, const char* end, T& value)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    const char* str = bind_begin(begin, end);
+    if(CPPJSON_NULL == str) {
+        return false;
+    }
+    return bind_end(JsonBind<T>::read(*this, str, value));
+}
+#endif // CPPJSON_NO_BIND
+
+/**
+ * @brief writer of a Json document into a growable buffer
+ *
+ * Commas between members and elements are inserted by the writer, so values are written in the order of the document.
+ * ```cpp
+ * JsonWriter writer;
+ * writer.beginObject();
+ * writer.key("id");
+ * writer.writeInt64(1);
+ * writer.endObject();
+ * std::string_view json(writer.data(), writer.size());
+ * ```
+ * The buffer is reused by clear, and it is valid until the next write or the destruction.
+ * Keys and strings are escaped, and the nesting is not checked.
+ */
+class JsonWriter
+{
+public:
+    static constexpr uint64_t Expand = 256; //!< the minimum expansion of buffer's capacity
+
+    /**
+     * @param alloc ... the function for memory allocation
+     * @param dealloc ... the furnction for memory deallocation
+     * @param realloc ... the function for memory reallocation, optional
+     * @warning the alloc and dealloc must be passed simultaneously
+     */
+    JsonWriter(CPPJSON_MALLOC_TYPE alloc = CPPJSON_NULL, CPPJSON_FREE_TYPE dealloc = CPPJSON_NULL, CPPJSON_REALLOC_TYPE realloc = CPPJSON_NULL);
+
+    /**
+     * @param allocator ... the memory functions
+     */
+    explicit JsonWriter(const JsonAllocator& allocator);
+    ~JsonWriter();
+
+    /**
+     * @brief Discard the written document, keeping the buffer
+     */
+    void clear();
+
+    /**
+     * @brief Reserve the buffer
+     * @param capacity ... the size in bytes
+     * @return false if the allocation failed
+     */
+    bool reserve(uint64_t capacity);
+
+    /**
+     * @return the written document, which is not null terminated
+     */
+    const char* data() const;
+
+    /**
+     * @return size of the written document
+     */
+    uint64_t size() const;
+
+    bool beginObject();
+    bool endObject();
+    bool beginArray();
+    bool endArray();
+
+    /**
+     * @brief Write a key of an object's member, the value follows
+     * @param key ... escaped while writing
+     * @return false if the allocation failed
+     */
+    bool key(std::string_view key);
+
+    /**
+     * @brief Write a string
+     * @param value ... escaped while writing
+     * @return false if the allocation failed
+     */
+    bool writeString(std::string_view value);
+
+    bool writeInt64(int64_t value);
+    bool writeUInt64(uint64_t value);
+
+    /**
+     * @brief Write a float with the shortest digits which are converted back to the same value
+     *
+     * Infinities and NaNs are not in Json, so those are written as null.
+     * @return false if the allocation failed
+     */
+    bool writeFloat64(double value);
+
+    bool writeBool(bool value);
+    bool writeNull();
+
+    /**
+     * @brief Write a value as is
+     * @param json ... a valid Json value
+     * @return false if the allocation failed
+     */
+    bool writeRaw(std::string_view json);
+
+    /**
+     * @brief Write an element of a JsonReader
+     *
+     * Strings and numbers are copied from the document without conversions.
+     * Objects and arrays are copied from the document as is, including whitespaces,
+     * but those of a document parsed with a projection are written member by member.
+     * An object's entry is written as its key and value.
+     * @param element
+     * @return false if the allocation failed
+     * @pre element is valid
+     * @pre the document of element is alive
+     */
+    bool write(const JsonProxy& element);
+
+    /**
+     * @brief Write a document as a value without whitespaces
+     *
+     * Whitespaces outside of strings are removed, and the rest is copied 64 bytes at a time.
+     * The document is not validated.
+     * @param begin
+     * @param end
+     * @return false if the allocation failed
+     */
+    bool minify(const char* begin, const char* end);
+
+    /**
+     * @brief Write a document as a value, a line for each member or element
+     *
+     * Whitespaces between tokens are replaced, and strings and numbers are copied as is.
+     * Empty objects and arrays stay in a line. The document is not validated.
+     * @param begin
+     * @param end
+     * @param indent ... the number of spaces for each nesting
+     * @return false if the allocation failed
+     */
+    bool prettify(const char* begin, const char* end, uint32_t indent = 4);
+
+    /**
+     * @brief Remove whitespaces outside of strings in place
+     * @param begin
+     * @param end
+     * @return size of the result from begin
+     */
+    static uint64_t minifyInPlace(char* begin, char* end);
+
+private:
+    JsonWriter(const JsonFunctions& functions, const JsonAllocator& allocator);
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    void* allocate(size_t size) const;
+    void deallocate(void* ptr) const;
+    void* reallocate(void* ptr, size_t size, size_t new_size) const;
+    bool expand(uint64_t size);
+    bool separate(uint64_t size);
+    bool newline(uint64_t depth, uint32_t indent);
+    bool write_string(const char* str, uint64_t size);
+    bool write_raw_string(const char* str, uint64_t size);
+
+    JsonFunctions functions_; //!< the functions without a context
+    JsonAllocator allocator_; //!< the memory functions
+    uint64_t capacity_; //!< capacity of buffer
+    uint64_t size_; //!< size of the written document
+    char* buffer_; //!< the written document
+    bool comma_; //!< whether a comma precedes the next value
+};
+
+#ifndef CPPJSON_NO_THREADS
+/**
+ * @brief parser of newline delimited Json documents, which parses records in parallel
+ *
+ * A batch is split into chunks at newlines, and a pool of workers parses the chunks.
+ * Each worker appends records to its own JsonReader, whose buffers are reused between records and batches.
+ * Records are numbered in the order of the batch.
+ * ```cpp
+ * JsonLineReader reader;
+ * reader.parse(begin, end);
+ * for(uint64_t i = 0; i < reader.size(); ++i) {
+ *     if(reader.valid(i)) {
+ *         JsonProxy record = reader.root(i);
+ *     }
+ * }
+ * ```
+ * Lines which have only whitespaces are skipped. Define CPPJSON_NO_THREADS to remove this class.
+ */
+class JsonLineReader
+{
+public:
+    static constexpr uint32_t ChunksPerThread = 8; //!< the number of chunks per thread, for balancing loads
+    static constexpr uint64_t MinChunk = 64 * 1024; //!< the minimum size of a chunk in bytes
+
+    /**
+     * @param threads ... the number of threads including the caller's, 0 means the number of hardware threads
+     * @param max_nesting ... the maximum of nesting for objects or arrays
+     * @param alloc ... the function for memory allocation
+     * @param dealloc ... the furnction for memory deallocation
+     * @param realloc ... the function for memory reallocation, optional
+     * @warning the alloc and dealloc must be passed simultaneously
+     */
+    explicit JsonLineReader(uint32_t threads = 0, int32_t max_nesting = JsonReader::MaxNesting, CPPJSON_MALLOC_TYPE alloc = CPPJSON_NULL, CPPJSON_FREE_TYPE dealloc = CPPJSON_NULL, CPPJSON_REALLOC_TYPE realloc = CPPJSON_NULL);
+
+    /**
+     * @param threads ... the number of threads including the caller's, 0 means the number of hardware threads
+     * @param max_nesting ... the maximum of nesting for objects or arrays
+     * @param allocator ... the memory functions, which the workers call concurrently
+     */
+    JsonLineReader(uint32_t threads, int32_t max_nesting, const JsonAllocator& allocator);
+    ~JsonLineReader();
+
+    /**
+     * @brief Enable decoding numbers while parsing, see JsonReader::setNumberDecoding
+     * @param enable
+     */
+    void setNumberDecoding(bool enable);
+
+    /**
+     * @brief Set the memory for open objects or arrays of each worker, see JsonReader::setStackBudget
+     * @param bytes
+     */
+    void setStackBudget(uint64_t bytes);
+
+    /**
+     * @param begin
+     * @param end
+     * @return true if all records are valid, false if any record is invalid or the allocation failed
+     * @pre begin != null
+     * @pre end != null
+     * @pre begin<=end
+     */
+    bool parse(const char* begin, const char* end);
+
+    /**
+     * @return the number of threads including the caller's, fewer than requested if threads could not be allocated or started
+     */
+    uint32_t threads() const;
+
+    /**
+     * @return the number of records
+     */
+    uint64_t size() const;
+
+    /**
+     * @param index ... the index of a record
+     * @return true if the record is valid
+     */
+    bool valid(uint64_t index) const;
+
+    /**
+     * @param index ... the index of a record
+     * @return the root of the record, or an invalid element if the record is invalid
+     */
+    JsonProxy root(uint64_t index) const;
+
+    /**
+     * @brief Build the tables of large objects and arrays of all records, see JsonReader::buildTables
+     * @return false if the allocation failed
+     */
+    bool buildTables();
+
+private:
+    JsonLineReader(uint32_t threads, int32_t max_nesting, const JsonFunctions& functions, const JsonAllocator& allocator);
+    JsonLineReader(const JsonLineReader&) = delete;
+    JsonLineReader& operator=(const JsonLineReader&) = delete;
+
+    /**
+     * @brief A record of a batch
+     */
+    struct Record
+    {
+        uint32_t worker_; //!< the worker which parsed the record
+        uint32_t root_; //!< the root of the record, or Invalid
+    };
+
+    /**
+     * @brief A range of a batch, which is parsed by one worker
+     */
+    struct Chunk
+    {
+        const char* begin_; //!< begin of the chunk
+        const char* end_; //!< end of the chunk
+        uint32_t worker_; //!< the worker which parsed the chunk
+        uint64_t first_; //!< the first record of the chunk in the worker's records
+        uint64_t size_; //!< the number of records of the chunk
+    };
+
+    /**
+     * @brief A worker's reader and records
+     */
+    struct Worker
+    {
+        JsonReader* reader_; //!< the reader which the records are appended to
+        uint64_t capacity_; //!< capacity of records
+        uint64_t size_; //!< size of records
+        uint32_t* roots_; //!< the roots of records, or Invalid
+        bool failed_; //!< whether the allocation failed
+    };
+
+    void* allocate(size_t size) const;
+    void deallocate(void* ptr) const;
+    void* reallocate(void* ptr, size_t size, size_t new_size) const;
+    void run(uint32_t worker);
+    void work(uint32_t worker);
+    bool parse(Worker& worker, Chunk& chunk);
+
+    JsonFunctions functions_; //!< the functions without a context
+    JsonAllocator allocator_; //!< the memory functions
+    const char* begin_; //!< begin of the batch
+    uint32_t threads_; //!< the number of threads including the caller's
+    Worker* workers_; //!< workers
+    std::thread* pool_; //!< threads except the caller's
+    uint32_t chunk_capacity_; //!< capacity of chunks
+    uint32_t chunk_size_; //!< size of chunks
+    Chunk* chunks_; //!< chunks of the batch
+    uint64_t record_capacity_; //!< capacity of records
+    uint64_t record_size_; //!< size of records
+    Record* records_; //!< records of the batch
+
+    std::mutex mutex_; //!< the mutex for the states of the pool
+    std::condition_variable start_; //!< notified when a batch starts
+    std::condition_variable done_; //!< notified when a worker finishes a batch
+    uint64_t generation_; //!< incremented for each batch
+    uint32_t running_; //!< the number of threads running on the current batch
+    bool quit_; //!< whether threads should quit
+    std::atomic<uint32_t> next_; //!< the next chunk to parse
+};
+
+/**
+ * @brief Readers which keep their buffers across requests
+ *
+ * acquire takes an idle reader or creates one, and release gives it back for the next acquire.
+ * A released reader whose buffers exceed the high-water mark is shrunk, so that a large document does not pin memory.
+ * Readers beyond the maximum of idle readers are destroyed. Settings of readers are kept except the projection.
+ * This is thread safe. Define CPPJSON_NO_THREADS to remove this class.
+ * ```cpp
+ * JsonReader* reader = pool.acquire();
+ * if(reader->parse(begin, end)) {
+ *     ...
+ * }
+ * pool.release(reader);
+ * ```
+ */
+class JsonReaderPool
+{
+public:
+    static constexpr uint32_t MaxIdle = 64; //!< the default maximum of idle readers
+    static constexpr uint64_t HighWater = 4 * 1024 * 1024; //!< the default maximum size of each buffer kept by idle readers
+
+    /**
+     * @brief Statistics of a pool
+     */
+    struct Statistics
+    {
+        uint64_t acquires_; //!< the number of acquires
+        uint64_t reuses_; //!< the number of acquires which took an idle reader
+        uint64_t shrinks_; //!< the number of releases which shrank the reader
+        uint64_t destroys_; //!< the number of readers destroyed by releases or trim
+        uint32_t idle_; //!< the number of idle readers
+        uint64_t memory_; //!< the bytes of buffers kept by idle readers
+    };
+
+    /**
+     * @param max_idle ... the maximum of idle readers
+     * @param high_water ... the maximum size of each buffer kept by released readers, see JsonReader::shrink
+     * @param max_nesting ... the maximum of nesting of readers
+     * @param alloc ... the function for memory allocation
+     * @param dealloc ... the furnction for memory deallocation
+     * @param realloc ... the function for memory reallocation, optional
+     * @warning the alloc and dealloc must be passed simultaneously
+     */
+    explicit JsonReaderPool(uint32_t max_idle = MaxIdle, uint64_t high_water = HighWater, int32_t max_nesting = JsonReader::MaxNesting, CPPJSON_MALLOC_TYPE alloc = CPPJSON_NULL, CPPJSON_FREE_TYPE dealloc = CPPJSON_NULL, CPPJSON_REALLOC_TYPE realloc = CPPJSON_NULL);
+
+    /**
+     * @param max_idle ... the maximum of idle readers
+     * @param high_water ... the maximum size of each buffer kept by released readers, see JsonReader::shrink
+     * @param max_nesting ... the maximum of nesting of readers
+     * @param allocator ... the memory functions, which readers of several threads call concurrently
+     */
+    JsonReaderPool(uint32_t max_idle, uint64_t high_water, int32_t max_nesting, const JsonAllocator& allocator);
+
+    /**
+     * @brief Destroy idle readers, all readers must be released before
+     */
+    ~JsonReaderPool();
+
+    /**
+     * @return an idle reader or a new one, or null if the allocation failed
+     */
+    JsonReader* acquire();
+
+    /**
+     * @brief Give back a reader, the document and the settings of the reader are discarded
+     * @param reader ... a reader acquired from this, or null
+     */
+    void release(JsonReader* reader);
+
+    /**
+     * @brief Destroy all idle readers
+     */
+    void trim();
+
+    /**
+     * @return the statistics
+     */
+    Statistics statistics() const;
+
+private:
+    JsonReaderPool(uint32_t max_idle, uint64_t high_water, int32_t max_nesting, const JsonFunctions& functions, const JsonAllocator& allocator);
+    JsonReaderPool(const JsonReaderPool&) = delete;
+    JsonReaderPool& operator=(const JsonReaderPool&) = delete;
+
+    void* allocate(size_t size) const;
+    void deallocate(void* ptr) const;
+    void destroy(JsonReader* reader);
+
+    JsonFunctions functions_; //!< the functions without a context
+    JsonAllocator allocator_; //!< the memory functions
+    uint32_t max_idle_; //!< the maximum of idle readers
+    uint64_t high_water_; //!< the maximum size of each buffer kept by idle readers
+    int32_t max_nesting_; //!< the maximum of nesting of readers
+    uint32_t idle_size_; //!< size of idle readers
+    JsonReader** idle_; //!< idle readers, max_idle_ entries
+
+    mutable std::mutex mutex_; //!< the mutex for idle readers and statistics
+    Statistics statistics_; //!< the statistics except idle_ and memory_
+};
+#endif // CPPJSON_NO_THREADS
+} // namespace cppjson
+
+#endif // INC_CPPJSON_H_
+
+#ifdef CPPJSON_IMPLEMENTATION
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    define CPPJSON_MMAP
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#ifndef CPPJSON_NO_SIMD
+#    if defined(__AVX2__)
+#        define CPPJSON_AVX2
+#        define CPPJSON_SSE2
+#        include <immintrin.h>
+#    elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#        define CPPJSON_SSE2
+#        include <emmintrin.h>
+#    endif
+#    if defined(__SSSE3__) || defined(__AVX__)
+#        define CPPJSON_SSSE3
+#        include <tmmintrin.h>
+#    endif
+#    if defined(__PCLMUL__) || (defined(_MSC_VER) && defined(__AVX2__))
+#        define CPPJSON_PCLMUL
+#        include <wmmintrin.h>
+#    endif
+#endif // CPPJSON_NO_SIMD
+
+#ifdef _MSC_VER
+#    include <intrin.h>
+#endif
+
+namespace cppjson
+{
+
+namespace
+{
+/**
+ * @brief classification of a 64 bytes block, one bit per byte
+ */
+struct JsonBlock
+{
+    uint64_t quote_;
+    uint64_t backslash_;
+    uint64_t whitespace_;
+    uint64_t structural_;
+    uint64_t special_; //!< backslashes, control characters and non-ascii characters
+};
+
+inline bool is_continuation(uint8_t x)
+{
+    return 0x80U <= x && x <= 0xBFU;
+}
+
+inline uint32_t count_trailing_zeros(uint64_t x)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(x));
+#endif
+}
+
+#if defined(CPPJSON_AVX2)
+inline uint64_t compare(__m256i x0, __m256i x1, char c)
+{
+    __m256i v = _mm256_set1_epi8(c);
+    uint64_t m0 = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x0, v)));
+    uint64_t m1 = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x1, v)));
+    return m0 | (m1 << 32);
+}
+
+inline void classify(JsonBlock& block, const char* str)
+{
+    __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str));
+    __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + 32));
+    block.quote_ = compare(x0, x1, '"');
+    block.backslash_ = compare(x0, x1, '\\');
+    block.whitespace_ = compare(x0, x1, 0x20) | compare(x0, x1, 0x0A) | compare(x0, x1, 0x0D) | compare(x0, x1, 0x09);
+    // '[' and ']' become '{' and '}' by setting the bit 0x20
+    __m256i lower = _mm256_set1_epi8(0x20);
+    __m256i l0 = _mm256_or_si256(x0, lower);
+    __m256i l1 = _mm256_or_si256(x1, lower);
+    block.structural_ = compare(l0, l1, '{') | compare(l0, l1, '}') | compare(x0, x1, ':') | compare(x0, x1, ',');
+    // bytes not greater than 0x1F, or having the most significant bit
+    __m256i control = _mm256_set1_epi8(0x1F);
+    uint64_t c0 = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(x0, control), x0)));
+    uint64_t c1 = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(x1, control), x1)));
+    uint64_t h0 = static_cast<uint32_t>(_mm256_movemask_epi8(x0));
+    uint64_t h1 = static_cast<uint32_t>(_mm256_movemask_epi8(x1));
+    block.special_ = block.backslash_ | c0 | (c1 << 32) | h0 | (h1 << 32);
+}
+#elif defined(CPPJSON_SSE2)
+inline uint64_t compare(__m128i x0, __m128i x1, __m128i x2, __m128i x3, char c)
+{
+    __m128i v = _mm_set1_epi8(c);
+    uint64_t m0 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x0, v)));
+    uint64_t m1 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x1, v)));
+    uint64_t m2 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x2, v)));
+    uint64_t m3 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x3, v)));
+    return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+}
+
+inline void classify(JsonBlock& block, const char* str)
+{
+    __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+    __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + 16));
+    __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + 32));
+    __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + 48));
+    block.quote_ = compare(x0, x1, x2, x3, '"');
+    block.backslash_ = compare(x0, x1, x2, x3, '\\');
+    block.whitespace_ = compare(x0, x1, x2, x3, 0x20) | compare(x0, x1, x2, x3, 0x0A) | compare(x0, x1, x2, x3, 0x0D) | compare(x0, x1, x2, x3, 0x09);
+    // '[' and ']' become '{' and '}' by setting the bit 0x20
+    __m128i lower = _mm_set1_epi8(0x20);
+    __m128i l0 = _mm_or_si128(x0, lower);
+    __m128i l1 = _mm_or_si128(x1, lower);
+    __m128i l2 = _mm_or_si128(x2, lower);
+    __m128i l3 = _mm_or_si128(x3, lower);
+    block.structural_ = compare(l0, l1, l2, l3, '{') | compare(l0, l1, l2, l3, '}') | compare(x0, x1, x2, x3, ':') | compare(x0, x1, x2, x3, ',');
+    // bytes not greater than 0x1F, or having the most significant bit
+    __m128i control = _mm_set1_epi8(0x1F);
+    __m128i s0 = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(x0, control), x0), x0);
+    __m128i s1 = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(x1, control), x1), x1);
+    __m128i s2 = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(x2, control), x2), x2);
+    __m128i s3 = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(x3, control), x3), x3);
+    uint64_t m0 = static_cast<uint32_t>(_mm_movemask_epi8(s0));
+    uint64_t m1 = static_cast<uint32_t>(_mm_movemask_epi8(s1));
+    uint64_t m2 = static_cast<uint32_t>(_mm_movemask_epi8(s2));
+    uint64_t m3 = static_cast<uint32_t>(_mm_movemask_epi8(s3));
+    block.special_ = block.backslash_ | m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+}
+#else
+inline void classify(JsonBlock& block, const char* str)
+{
+    block.quote_ = 0;
+    block.backslash_ = 0;
+    block.whitespace_ = 0;
+    block.structural_ = 0;
+    block.special_ = 0;
+    for(uint32_t i = 0; i < 64; ++i) {
+        uint64_t bit = 1ULL << i;
+        if(static_cast<uint8_t>(str[i]) < 0x20U || 0x80U <= static_cast<uint8_t>(str[i])) {
+            block.special_ |= bit;
+        }
+        switch(str[i]) {
+        case '"':
+            block.quote_ |= bit;
+            break;
+        case '\\':
+            block.backslash_ |= bit;
+            block.special_ |= bit;
+            break;
+        case 0x20:
+        case 0x0A:
+        case 0x0D:
+        case 0x09:
+            block.whitespace_ |= bit;
+            break;
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ':':
+        case ',':
+            block.structural_ |= bit;
+            break;
+        default:
+            break;
+        }
+    }
+}
+#endif
+
+#if defined(CPPJSON_SSSE3)
+/**
+ * @brief Validate UTF-8 sequences of 16 bytes with lookup tables
+ *
+ * "Validating UTF-8 In Less Than One Instruction Per Byte", John Keiser and Daniel Lemire.
+ * Each pair of consecutive bytes is classified by three table lookups of their nibbles,
+ * and the third and fourth bytes of sequences are checked against the leading bytes.
+ * @param input ... the current bytes
+ * @param prev ... the previous bytes
+ * @return non zero bytes for errors
+ */
+inline __m128i check_utf8(__m128i input, __m128i prev)
+{
+    static constexpr uint8_t TooShort = 1 << 0; // 11______ 0_______, 11______ 11______
+    static constexpr uint8_t TooLong = 1 << 1; // 0_______ 10______
+    static constexpr uint8_t Overlong3 = 1 << 2; // 11100000 100_____
+    static constexpr uint8_t TooLarge = 1 << 3; // 11110100 1001____, 11110100 101_____, 111101__ 10______, 11111___ 10______
+    static constexpr uint8_t Surrogate = 1 << 4; // 11101101 101_____
+    static constexpr uint8_t Overlong2 = 1 << 5; // 1100000_ 10______
+    static constexpr uint8_t TooLarge1000 = 1 << 6; // 11110101 1000____, 1111011_ 1000____, 11111___ 1000____
+    static constexpr uint8_t Overlong4 = 1 << 6; // 11110000 1000____
+    static constexpr uint8_t TwoConts = 1 << 7; // 10______ 10______
+    static constexpr uint8_t Carry = TooShort | TooLong | TwoConts;
+
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+        TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+        TwoConts, TwoConts, TwoConts, TwoConts,
+        TooShort | Overlong2,
+        TooShort,
+        TooShort | Overlong3 | Surrogate,
+        static_cast<char>(TooShort | TooLarge | TooLarge1000 | Overlong4));
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+        static_cast<char>(Carry | Overlong3 | Overlong2 | Overlong4),
+        static_cast<char>(Carry | Overlong2),
+        static_cast<char>(Carry),
+        static_cast<char>(Carry),
+        static_cast<char>(Carry | TooLarge),
+        static_cast<char>(Carry | TooLarge | TooLarge1000),
+        static_cast<char>(Carry | TooLarge | TooLarge1000),
+        static_cast<char>(Carry | TooLarge | TooLarge1000),
+        static_cast<char>(Carry | TooLarge | TooLarge1000),
+        static_cast<char>(Carry | TooLarge | TooLarge1000),
+        static_cast<char>(Carry | TooLarge | TooLarge1000),
+        static_cast<char>(Carry | TooLarge | TooLarge1000),
+        static_cast<char>(Carry | TooLarge | TooLarge1000),
+        static_cast<char>(Carry | TooLarge | TooLarge1000 | Surrogate),
+        static_cast<char>(Carry | TooLarge | TooLarge1000),
+        static_cast<char>(Carry | TooLarge | TooLarge1000));
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+        TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+        static_cast<char>(TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1000 | Overlong4),
+        static_cast<char>(TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge),
+        static_cast<char>(TooLong | Overlong2 | TwoConts | Surrogate | TooLarge),
+        static_cast<char>(TooLong | Overlong2 | TwoConts | Surrogate | TooLarge),
+        TooShort, TooShort, TooShort, TooShort);
+
+    const __m128i low = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table, _mm_and_si128(_mm_srli_epi16(prev1, 4), low));
+    __m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, low));
+    __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table, _mm_and_si128(_mm_srli_epi16(input, 4), low));
+    __m128i special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // The third and fourth bytes must be continuations
+    __m128i prev2 = _mm_alignr_epi8(input, prev, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, prev, 13);
+    __m128i is_third = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    __m128i is_fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(is_third, is_fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+    return _mm_xor_si128(must23, special_cases);
+}
+#endif
+
+/**
+ * @brief Set all bits between pairs of bits, including the first bit of each pair
+ */
+inline uint64_t prefix_xor(uint64_t x)
+{
+#if defined(CPPJSON_PCLMUL)
+    __m128i all = _mm_set1_epi8(static_cast<char>(0xFF));
+    __m128i result = _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<int64_t>(x)), all, 0);
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(result));
+#else
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+#endif
+}
+
+/**
+ * @brief Find strings in a block
+ * @param block ... the classified block
+ * @param [in,out] escaped ... whether the first byte of the block is escaped
+ * @param [in,out] in_string ... whether the previous block ends inside of a string
+ * @param [out] quote ... unescaped quotes
+ * @return bits inside of strings, including the opening quotes and excluding the closing quotes
+ */
+inline uint64_t find_strings(const JsonBlock& block, uint64_t& escaped, uint64_t& in_string, uint64_t& quote)
+{
+    static constexpr uint64_t OddBits = 0xAAAAAAAAAAAAAAAAULL;
+
+    // Find escaped characters, odd sequences of backslashes escape the following characters
+    uint64_t potential_escape = block.backslash_ & ~escaped;
+    uint64_t escape_and_terminal = (((potential_escape << 1) | OddBits) - potential_escape) ^ OddBits;
+    uint64_t escapes = escape_and_terminal ^ (block.backslash_ | escaped);
+    escaped = (escape_and_terminal & block.backslash_) >> 63;
+
+    // Strings are between pairs of unescaped quotes
+    quote = block.quote_ & ~escapes;
+    uint64_t string = prefix_xor(quote) ^ in_string;
+    in_string = static_cast<uint64_t>(static_cast<int64_t>(string) >> 63);
+    return string;
+}
+
+/**
+ * @brief FNV-1a hash of the size and all bytes of a document
+ *
+ * Words of 8 bytes are hashed at a time, and a modification of any word changes the hash.
+ */
+inline uint64_t hash_document(const char* begin, const char* end)
+{
+    uint64_t size = static_cast<uint64_t>(end - begin);
+    uint64_t hash = (14695981039346656037ULL ^ size) * 1099511628211ULL;
+    const char* str = begin;
+    for(; 8 <= (end - str); str += 8) {
+        uint64_t word;
+        ::memcpy(&word, str, 8);
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    for(; str < end; ++str) {
+        hash = (hash ^ static_cast<uint8_t>(str[0])) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief FNV-1a hash of a key
+ */
+inline uint32_t hash_key(const char* str, uint64_t size)
+{
+    uint32_t hash = 2166136261U;
+    for(uint64_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(str[i])) * 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * @brief Convert a number with the standard library
+ *
+ * The whole token is converted, however long it is. A result out of range is an infinity or a zero by the magnitude of the number.
+ */
+inline double to_float64(const char* first, const char* last)
+{
+    double value = 0;
+    std::from_chars_result result = std::from_chars(first, last, value);
+    if(std::errc::result_out_of_range != result.ec) {
+        return value;
+    }
+    // The magnitude is the position of the first significant digit, shifted by the exponent
+    const char* str = first;
+    bool negative = '-' == str[0];
+    str += negative ? 1 : 0;
+    int64_t magnitude = 0;
+    bool significant = false;
+    for(; str < last && '0' <= str[0] && str[0] <= '9'; ++str) {
+        significant = significant || '0' != str[0];
+        magnitude += significant ? 1 : 0;
+    }
+    if(str < last && '.' == str[0]) {
+        for(++str; str < last && '0' <= str[0] && str[0] <= '9'; ++str) {
+            if(!significant) {
+                significant = '0' != str[0];
+                magnitude -= significant ? 0 : 1;
+            }
+        }
+    }
+    if(str < last && ('e' == str[0] || 'E' == str[0])) {
+        ++str;
+        bool negative_exponent = str < last && '-' == str[0];
+        str += (str < last && ('-' == str[0] || '+' == str[0])) ? 1 : 0;
+        int64_t exponent = 0;
+        for(; str < last && '0' <= str[0] && str[0] <= '9'; ++str) {
+            exponent = exponent < 100000000 ? exponent * 10 + (str[0] - '0') : exponent;
+        }
+        magnitude += negative_exponent ? -exponent : exponent;
+    }
+    value = 0 < magnitude ? HUGE_VAL : 0.0;
+    return negative ? -value : value;
+}
+
+/**
+ * @brief Convert a valid number to float
+ *
+ * Clinger's fast path, if the significand and the power of ten are exactly representable,
+ * the result of one multiplication or division is correctly rounded. Other numbers fall back to the standard library.
+ */
+inline double decode_float(const char* first, const char* last)
+{
+    static constexpr double Powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    static constexpr uint64_t MaxSignificand = 1ULL << 53;
+    static constexpr int64_t MaxExponent = 22;
+
+    const char* str = first;
+    bool negative = '-' == str[0];
+    str += negative ? 1 : 0;
+    uint64_t significand = 0;
+    int64_t digits = 0;
+    int64_t exponent = 0;
+    for(; str < last && '0' <= str[0] && str[0] <= '9'; ++str) {
+        significand = significand * 10 + (str[0] - '0');
+        digits += (0 < digits || '0' != str[0]) ? 1 : 0;
+    }
+    if(str < last && '.' == str[0]) {
+        for(++str; str < last && '0' <= str[0] && str[0] <= '9'; ++str) {
+            significand = significand * 10 + (str[0] - '0');
+            digits += (0 < digits || '0' != str[0]) ? 1 : 0;
+            --exponent;
+        }
+    }
+    if(str < last && ('e' == str[0] || 'E' == str[0])) {
+        ++str;
+        bool negative_exponent = str < last && '-' == str[0];
+        str += (str < last && ('-' == str[0] || '+' == str[0])) ? 1 : 0;
+        int64_t e = 0;
+        for(; str < last && '0' <= str[0] && str[0] <= '9'; ++str) {
+            e = e < 100000 ? e * 10 + (str[0] - '0') : e;
+        }
+        exponent += negative_exponent ? -e : e;
+    }
+    // The significand wraps around over 19 digits
+    if(19 < digits) {
+        return to_float64(first, last);
+    }
+    if(0 == significand) {
+        return negative ? -0.0 : 0.0;
+    }
+    if(MaxSignificand < significand) {
+        return to_float64(first, last);
+    }
+    if(MaxExponent < exponent) {
+        // Move a part of the exponent to the significand, while the significand is exact
+        for(; MaxExponent < exponent; --exponent) {
+            significand *= 10;
+            if(MaxSignificand < significand) {
+                return to_float64(first, last);
+            }
+        }
+    }
+    double value = static_cast<double>(significand);
+    if(exponent < -MaxExponent) {
+        return to_float64(first, last);
+    } else if(exponent < 0) {
+        value /= Powers[-exponent];
+    } else {
+        value *= Powers[exponent];
+    }
+    return negative ? -value : value;
+}
+
+inline const char* skip_whitespace(const char* str, const char* end)
+{
+    while(str < end && (0x20 == str[0] || 0x0A == str[0] || 0x0D == str[0] || 0x09 == str[0])) {
+        ++str;
+    }
+    return str;
+}
+
+/**
+ * @brief Skip a string
+ * @param str ... the opening quote
+ * @param end
+ * @return the next of the closing quote, or null
+ */
+inline const char* skip_string(const char* str, const char* end)
+{
+    ++str;
+#if defined(CPPJSON_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while(16 <= (end - str)) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash))));
+        if(0 == mask) {
+            str += 16;
+            continue;
+        }
+        str += count_trailing_zeros(mask);
+        if('"' == str[0]) {
+            return str + 1;
+        }
+        str += 2;
+    }
+#endif
+    for(; str < end; ++str) {
+        if('"' == str[0]) {
+            return str + 1;
+        }
+        if('\\' == str[0]) {
+            ++str;
+        }
+    }
+    return CPPJSON_NULL;
+}
+
+/**
+ * @brief Skip a number or a literal
+ */
+inline const char* skip_token(const char* str, const char* end)
+{
+    while(str < end) {
+        switch(str[0]) {
+        case 0x20:
+        case 0x0A:
+        case 0x0D:
+        case 0x09:
+        case ',':
+        case ':':
+        case ']':
+        case '}':
+            return str;
+        default:
+            ++str;
+            break;
+        }
+    }
+    return str;
+}
+
+/**
+ * @brief Skip an object or array by counting brackets outside of strings
+ * @param str ... the opening bracket
+ * @param end
+ * @return the next of the closing bracket, or null
+ */
+inline const char* skip_aggregation(const char* str, const char* end)
+{
+    uint64_t size = static_cast<uint64_t>(end - str);
+    int64_t depth = 0;
+    uint64_t escaped = 0;
+    uint64_t in_string = 0;
+    for(uint64_t offset = 0; offset < size; offset += 64) {
+        const char* block_str = str + offset;
+        char tail[64];
+        if((size - offset) < 64) {
+            ::memset(tail, 0x20, sizeof(tail));
+            ::memcpy(tail, block_str, size - offset);
+            block_str = tail;
+        }
+        JsonBlock block;
+        classify(block, block_str);
+        uint64_t quote;
+        uint64_t structurals = block.structural_ & ~find_strings(block, escaped, in_string, quote);
+        while(0 != structurals) {
+            uint64_t position = offset + count_trailing_zeros(structurals);
+            structurals &= structurals - 1;
+            switch(str[position]) {
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if(--depth <= 0) {
+                    return str + position + 1;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return CPPJSON_NULL;
+}
+
+inline const char* skip_value(const char* str, const char* end)
+{
+    switch(str[0]) {
+    case '"':
+        return skip_string(str, end);
+    case '{':
+    case '[':
+        return skip_aggregation(str, end);
+    default: {
+        const char* next = skip_token(str, end);
+        return str < next ? next : CPPJSON_NULL;
+    }
+    }
+}
+
+/**
+ * @brief Remove whitespaces outside of strings
+ * @param str
+ * @param end
+ * @param out ... the output, which is str or another buffer of the same size
+ * @return the end of the output
+ */
+inline char* minify_to(const char* str, const char* end, char* out)
+{
+    uint64_t size = static_cast<uint64_t>(end - str);
+    uint64_t escaped = 0;
+    uint64_t in_string = 0;
+    for(uint64_t offset = 0; offset < size; offset += 64) {
+        const char* block_str = str + offset;
+        char tail[64];
+        uint64_t removed = 0;
+        if((size - offset) < 64) {
+            ::memset(tail, 0x20, sizeof(tail));
+            ::memcpy(tail, block_str, size - offset);
+            block_str = tail;
+            removed = ~0ULL << (size - offset);
+        }
+        JsonBlock block;
+        classify(block, block_str);
+        uint64_t quote;
+        removed |= block.whitespace_ & ~find_strings(block, escaped, in_string, quote);
+        // Blocks are loaded before stored, since the output may overlap the input
+        char copy[64];
+        ::memcpy(copy, block_str, 64);
+        if(0 == removed) {
+            ::memcpy(out, copy, 64);
+            out += 64;
+            continue;
+        }
+        // Runs between whitespaces are copied
+        uint64_t kept = ~removed;
+        while(0 != kept) {
+            uint32_t first = count_trailing_zeros(kept);
+            uint64_t rest = ~(kept >> first);
+            uint32_t length = 0 == rest ? 64 - first : count_trailing_zeros(rest);
+            ::memcpy(out, copy + first, length);
+            out += length;
+            if(64 <= (first + length)) {
+                break;
+            }
+            kept &= ~0ULL << (first + length);
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Find a character which needs an escape in a string
+ * @return the position of the character, or end
+ */
+inline const char* find_escape(const char* str, const char* end)
+{
+#if defined(CPPJSON_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    while(16 <= (end - str)) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+        // Control characters are the bytes which are not changed by the unsigned minimum with 0x1F
+        __m128i escapes = _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash));
+        escapes = _mm_or_si128(escapes, _mm_cmpeq_epi8(_mm_min_epu8(x, control), x));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(escapes));
+        if(0 != mask) {
+            return str + count_trailing_zeros(mask);
+        }
+        str += 16;
+    }
+#endif
+    while(str < end && '"' != str[0] && '\\' != str[0] && 0x20 <= static_cast<uint8_t>(str[0])) {
+        ++str;
+    }
+    return str;
+}
+
+/**
+ * @brief Convert four hexadecimal digits
+ */
+inline uint32_t decode_4hex(const char* str)
+{
+    uint32_t code = 0;
+    for(uint32_t i = 0; i < 4; ++i) {
+        uint32_t c = static_cast<uint8_t>(str[i]);
+        code = (code << 4) | (c <= '9' ? c - '0' : (c | 0x20U) - 'a' + 10);
+    }
+    return code;
+}
+
+/**
+ * @brief Decode the escapes of a valid string into UTF-8
+ * @return size of the result, which is not truncated by the capacity
+ */
+inline uint64_t unescape(const char* str, const char* end, char* out, uint64_t capacity)
+{
+    uint64_t limit = 0 < capacity ? capacity - 1 : 0;
+    uint64_t size = 0;
+    for(;;) {
+#if defined(CPPJSON_SSE2)
+        // Runs without escapes are copied 16 bytes at a time, while the output has room
+        const __m128i backslash = _mm_set1_epi8('\\');
+        while(16 <= (end - str) && (size + 16) <= limit) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + size), x);
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, backslash)));
+            uint32_t count = 0 != mask ? count_trailing_zeros(mask) : 16;
+            str += count;
+            size += count;
+            if(0 != mask) {
+                break;
+            }
+        }
+#endif
+        const char* run = reinterpret_cast<const char*>(::memchr(str, '\\', static_cast<size_t>(end - str)));
+        run = CPPJSON_NULL != run ? run : end;
+        uint64_t length = static_cast<uint64_t>(run - str);
+        if(size < limit) {
+            ::memcpy(out + size, str, static_cast<size_t>(length < (limit - size) ? length : (limit - size)));
+        }
+        size += length;
+        str = run;
+        if((end - str) < 2) {
+            break;
+        }
+
+        uint32_t code = static_cast<uint8_t>(str[1]);
+        str += 2;
+        switch(code) {
+        case 'b':
+            code = '\b';
+            break;
+        case 'f':
+            code = '\f';
+            break;
+        case 'n':
+            code = '\n';
+            break;
+        case 'r':
+            code = '\r';
+            break;
+        case 't':
+            code = '\t';
+            break;
+        case 'u':
+            if((end - str) < 4) {
+                return size;
+            }
+            code = decode_4hex(str);
+            str += 4;
+            // A high surrogate followed by a low surrogate is a pair, others are replaced
+            if(0xD800U <= code && code < 0xDC00U && 6 <= (end - str) && '\\' == str[0] && 'u' == str[1]) {
+                uint32_t low = decode_4hex(str + 2);
+                if(0xDC00U <= low && low < 0xE000U) {
+                    code = 0x10000U + ((code - 0xD800U) << 10) + (low - 0xDC00U);
+                    str += 6;
+                }
+            }
+            if(0xD800U <= code && code < 0xE000U) {
+                code = 0xFFFDU;
+            }
+            break;
+        default:
+            break;
+        }
+        char bytes[4];
+        uint32_t count = 1;
+        if(code < 0x80U) {
+            bytes[0] = static_cast<char>(code);
+        } else if(code < 0x800U) {
+            bytes[0] = static_cast<char>(0xC0U | (code >> 6));
+            bytes[1] = static_cast<char>(0x80U | (code & 0x3FU));
+            count = 2;
+        } else if(code < 0x10000U) {
+            bytes[0] = static_cast<char>(0xE0U | (code >> 12));
+            bytes[1] = static_cast<char>(0x80U | ((code >> 6) & 0x3FU));
+            bytes[2] = static_cast<char>(0x80U | (code & 0x3FU));
+            count = 3;
+        } else {
+            bytes[0] = static_cast<char>(0xF0U | (code >> 18));
+            bytes[1] = static_cast<char>(0x80U | ((code >> 12) & 0x3FU));
+            bytes[2] = static_cast<char>(0x80U | ((code >> 6) & 0x3FU));
+            bytes[3] = static_cast<char>(0x80U | (code & 0x3FU));
+            count = 4;
+        }
+        for(uint32_t i = 0; i < count; ++i, ++size) {
+            if(size < limit) {
+                out[size] = bytes[i];
+            }
+        }
+    }
+    if(0 < capacity) {
+        out[size < limit ? size : limit] = '\0';
+    }
+    return size;
+}
+
+/**
+ * @brief Check that a token ends at a position
+ */
+inline bool is_delimiter(const char* str, const char* end)
+{
+    return end <= str || skip_token(str, end) == str;
+}
+
+/**
+ * @brief Validate a number with the grammar of JsonReader::scan_number
+ * @return the next of the number, or null
+ */
+inline const char* scan_number_token(const char* str, const char* end, JsonType& type)
+{
+    type = JsonType::Integer;
+    str += (str < end && '-' == str[0]) ? 1 : 0;
+    if(end <= str || str[0] < '0' || '9' < str[0]) {
+        return CPPJSON_NULL;
+    }
+    if('0' == str[0]) {
+        ++str;
+    } else {
+        while(str < end && '0' <= str[0] && str[0] <= '9') {
+            ++str;
+        }
+    }
+    if(str < end && '.' == str[0]) {
+        type = JsonType::Number;
+        const char* digits = ++str;
+        while(str < end && '0' <= str[0] && str[0] <= '9') {
+            ++str;
+        }
+        if(digits == str) {
+            return CPPJSON_NULL;
+        }
+    }
+    if(str < end && ('e' == str[0] || 'E' == str[0])) {
+        type = JsonType::Number;
+        ++str;
+        str += (str < end && ('-' == str[0] || '+' == str[0])) ? 1 : 0;
+        const char* digits = str;
+        while(str < end && '0' <= str[0] && str[0] <= '9') {
+            ++str;
+        }
+        if(digits == str) {
+            return CPPJSON_NULL;
+        }
+    }
+    return str;
+}
+
+/**
+ * @brief Classify the element at a position
+ *
+ * Scalars are validated, and must be followed by a whitespace, a separator, a closing or the end.
+ */
+inline JsonCursor make_cursor(const char* str, const char* end)
+{
+    if(end <= str) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    switch(str[0]) {
+    case '{':
+        return {str, end, JsonType::Object};
+    case '[':
+        return {str, end, JsonType::Array};
+    case '"':
+        return {str, end, JsonType::String};
+    case 't':
+        if(4 <= (end - str) && 0 == ::memcmp(str, "true", 4) && is_delimiter(str + 4, end)) {
+            return {str, end, JsonType::True};
+        }
+        break;
+    case 'f':
+        if(5 <= (end - str) && 0 == ::memcmp(str, "false", 5) && is_delimiter(str + 5, end)) {
+            return {str, end, JsonType::False};
+        }
+        break;
+    case 'n':
+        if(4 <= (end - str) && 0 == ::memcmp(str, "null", 4) && is_delimiter(str + 4, end)) {
+            return {str, end, JsonType::Null};
+        }
+        break;
+    default: {
+        JsonType type;
+        const char* last = scan_number_token(str, end, type);
+        if(CPPJSON_NULL != last && is_delimiter(last, end)) {
+            return {str, end, type};
+        }
+    } break;
+    }
+    return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+}
+
+/**
+ * @brief Convert a valid integer
+ * @return the flags of the result
+ */
+inline uint32_t decode_integer(JsonNumber& number, const char* first, const char* last)
+{
+    const char* str = first;
+    bool negative = '-' == str[0];
+    str += negative ? 1 : 0;
+    uint64_t value = 0;
+    for(; str < last; ++str) {
+        uint64_t digit = static_cast<uint64_t>(str[0] - '0');
+        if((UINT64_MAX - digit) / 10 < value) {
+            number.float64_ = decode_float(first, last);
+            return JsonValue::Overflow;
+        }
+        value = value * 10 + digit;
+    }
+    if(negative) {
+        if((static_cast<uint64_t>(INT64_MAX) + 1) < value) {
+            number.float64_ = decode_float(first, last);
+            return JsonValue::Overflow;
+        }
+        number.uint64_ = 0ULL - value;
+        return 0;
+    }
+    number.uint64_ = value;
+    return static_cast<uint64_t>(INT64_MAX) < value ? JsonValue::UInt64 : 0;
+}
+
+void* functions_allocate(void* context, size_t size)
+{
+    return reinterpret_cast<JsonFunctions*>(context)->alloc_(size);
+}
+
+void functions_deallocate(void* context, void* ptr)
+{
+    reinterpret_cast<JsonFunctions*>(context)->dealloc_(ptr);
+}
+
+void* functions_reallocate(void* context, void* ptr, size_t, size_t new_size)
+{
+    return reinterpret_cast<JsonFunctions*>(context)->realloc_(ptr, new_size);
+}
+
+/**
+ * @brief Make memory functions which call the functions, which are replaced with malloc and free if missing
+ */
+JsonAllocator make_allocator(JsonFunctions& functions)
+{
+    if(CPPJSON_NULL == functions.alloc_ || CPPJSON_NULL == functions.dealloc_) {
+        functions = {::malloc, ::free, ::realloc};
+    }
+    return {functions_allocate, functions_deallocate, CPPJSON_NULL != functions.realloc_ ? functions_reallocate : CPPJSON_NULL, &functions};
+}
+
+void* arena_allocate(void* context, size_t size)
+{
+    return reinterpret_cast<JsonArena*>(context)->allocate(size);
+}
+
+void arena_deallocate(void* context, void* ptr)
+{
+    reinterpret_cast<JsonArena*>(context)->deallocate(ptr);
+}
+
+void* arena_reallocate(void* context, void* ptr, size_t size, size_t new_size)
+{
+    return reinterpret_cast<JsonArena*>(context)->reallocate(ptr, size, new_size);
+}
+
+void* pool_allocate(void* context, size_t size)
+{
+    return reinterpret_cast<JsonPool*>(context)->allocate(size);
+}
+
+void pool_deallocate(void* context, void* ptr)
+{
+    reinterpret_cast<JsonPool*>(context)->deallocate(ptr);
+}
+
+void* pool_reallocate(void* context, void* ptr, size_t size, size_t new_size)
+{
+    return reinterpret_cast<JsonPool*>(context)->reallocate(ptr, size, new_size);
+}
+
+#ifndef CPPJSON_NO_THREADS
+/**
+ * @brief Start a thread in uninitialized storage
+ * @return false if the thread cannot be started for limits of threads or resources, then the storage is left uninitialized
+ */
+template<class Function, class... Args>
+bool start_thread(std::thread* thread, Function function, Args... args)
+{
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+    try {
+        new(thread) std::thread(function, args...);
+    } catch(...) {
+        return false;
+    }
+#else
+    new(thread) std::thread(function, args...);
+#endif
+    return true;
+}
+#endif // CPPJSON_NO_THREADS
+} // namespace
+
+JsonStatus::operator bool() const
+{
+    return JsonError::None == error_;
+}
+
+JsonProxy::operator bool() const
+{
+    return JsonReader::Invalid != value_;
+}
+
+JsonType JsonProxy::type() const
+{
+    if(JsonReader::Invalid != value_) {
+        return static_cast<JsonType>(values_[value_].type_);
+    }
+    return JsonType::Invalid;
+}
+
+uint64_t JsonProxy::size() const
+{
+    CPPJSON_ASSERT(JsonReader::Invalid != value_);
+    return values_[value_].size_;
+}
+
+JsonProxy JsonProxy::begin() const
+{
+    CPPJSON_ASSERT(JsonReader::Invalid != value_);
+    if(static_cast<uint32_t>(JsonType::Object) != values_[value_].type_
+       && static_cast<uint32_t>(JsonType::Array) != values_[value_].type_) {
+        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
+    }
+    if(values_[value_].size_ <= 0) {
+        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
+    }
+    return {value_ + 1, data_, values_, numbers_, reader_};
+}
+
+JsonProxy JsonProxy::next() const
+{
+    CPPJSON_ASSERT(JsonReader::Invalid != value_);
+    if(static_cast<uint32_t>(JsonType::KeyValue) != values_[value_].type_
+       && static_cast<uint32_t>(JsonType::ArrayValue) != values_[value_].type_) {
+        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
+    }
+    return {values_[value_].next_, data_, values_, numbers_, reader_};
+}
+
+JsonProxy JsonProxy::key() const
+{
+    CPPJSON_ASSERT(JsonReader::Invalid != value_);
+    if(JsonType::KeyValue != type()) {
+        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
+    }
+    return {values_[value_].start_, data_, values_, numbers_, reader_};
+}
+
+JsonProxy JsonProxy::value() const
+{
+    CPPJSON_ASSERT(JsonReader::Invalid != value_);
+    if(JsonType::KeyValue != type() && JsonType::ArrayValue != type()) {
+        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
+    }
+    return {values_[value_].size_, data_, values_, numbers_, reader_};
+}
+
+uint64_t JsonProxy::getString(char* str) const
+{
+    ::memcpy(str, data_ + values_[value_].start_, values_[value_].size_);
+    str[values_[value_].size_] = '\0';
+    return values_[value_].size_;
+}
+
+uint64_t JsonProxy::getString(char* str, uint64_t capacity) const
+{
+    const JsonValue& element = values_[value_];
+    const char* first = data_ + element.start_;
+    if(0 == (element.flags_ & JsonValue::Escaped)) {
+        if(0 < capacity) {
+            uint64_t size = element.size_ < capacity ? element.size_ : capacity - 1;
+            ::memcpy(str, first, size);
+            str[size] = '\0';
+        }
+        return element.size_;
+    }
+    return unescape(first, first + element.size_, str, capacity);
+}
+
+std::string_view JsonProxy::getStringView() const
+{
+    return std::string_view(data_ + values_[value_].start_, static_cast<size_t>(values_[value_].size_));
+}
+
+bool JsonProxy::isEscaped() const
+{
+    return 0 != (values_[value_].flags_ & JsonValue::Escaped);
+}
+
+int64_t JsonProxy::getInt64() const
+{
+    const JsonValue& element = values_[value_];
+    if(0 != (element.flags_ & JsonValue::Decoded) && static_cast<uint32_t>(JsonType::Integer) == element.type_) {
+        return 0 == (element.flags_ & (JsonValue::UInt64 | JsonValue::Overflow)) ? numbers_[element.next_].int64_ : 0;
+    }
+    const char* first = data_ + element.start_;
+    const char* last = first + element.size_;
+    int64_t value = 0;
+    std::from_chars(first, last, value);
+    return value;
+}
+
+uint64_t JsonProxy::getUInt64() const
+{
+    const JsonValue& element = values_[value_];
+    if(0 != (element.flags_ & JsonValue::Decoded) && static_cast<uint32_t>(JsonType::Integer) == element.type_) {
+        if(0 != (element.flags_ & JsonValue::Overflow) || (0 == (element.flags_ & JsonValue::UInt64) && numbers_[element.next_].int64_ < 0)) {
+            return 0;
+        }
+        return numbers_[element.next_].uint64_;
+    }
+    const char* first = data_ + element.start_;
+    const char* last = first + element.size_;
+    uint64_t value = 0;
+    std::from_chars(first, last, value);
+    return value;
+}
+
+double JsonProxy::getFloat64() const
+{
+    const JsonValue& element = values_[value_];
+    if(0 != (element.flags_ & JsonValue::Decoded)) {
+        const JsonNumber& number = numbers_[element.next_];
+        if(static_cast<uint32_t>(JsonType::Number) == element.type_ || 0 != (element.flags_ & JsonValue::Overflow)) {
+            return number.float64_;
+        }
+        if(0 != (element.flags_ & JsonValue::UInt64)) {
+            return static_cast<double>(number.uint64_);
+        }
+        // Keep the sign of -0
+        return (0 == number.int64_ && '-' == data_[element.start_]) ? -0.0 : static_cast<double>(number.int64_);
+    }
+    const char* first = data_ + element.start_;
+    return decode_float(first, first + element.size_);
+}
+
+bool JsonProxy::isUInt64() const
+{
+    const JsonValue& element = values_[value_];
+    if(static_cast<uint32_t>(JsonType::Integer) != element.type_) {
+        return false;
+    }
+    if(0 != (element.flags_ & JsonValue::Decoded)) {
+        return 0 != (element.flags_ & JsonValue::UInt64);
+    }
+    JsonNumber number;
+    const char* first = data_ + element.start_;
+    return JsonValue::UInt64 == decode_integer(number, first, first + element.size_);
+}
+
+bool JsonProxy::isOverflow() const
+{
+    const JsonValue& element = values_[value_];
+    if(static_cast<uint32_t>(JsonType::Integer) != element.type_) {
+        return false;
+    }
+    if(0 != (element.flags_ & JsonValue::Decoded)) {
+        return 0 != (element.flags_ & JsonValue::Overflow);
+    }
+    JsonNumber number;
+    const char* first = data_ + element.start_;
+    return JsonValue::Overflow == decode_integer(number, first, first + element.size_);
+}
+
+bool JsonProxy::compareKey(const char* str) const
+{
+    CPPJSON_ASSERT(nullptr != str);
+    CPPJSON_ASSERT(JsonReader::Invalid != value_);
+    if(JsonType::KeyValue != type()) {
+        return false;
+    }
+    return reader_->equals(static_cast<uint32_t>(value_), str, ::strlen(str));
+}
+
+JsonProxy JsonProxy::find(std::string_view key) const
+{
+    CPPJSON_ASSERT(JsonReader::Invalid != value_);
+    if(JsonType::Object != type()) {
+        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
+    }
+    uint32_t entry = reader_->find(static_cast<uint32_t>(value_), key.data(), key.size());
+    if(JsonReader::Invalid == entry) {
+        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
+    }
+    return {values_[entry].size_, data_, values_, numbers_, reader_};
+}
+
+uint64_t JsonProxy::count() const
+{
+    CPPJSON_ASSERT(JsonReader::Invalid != value_);
+    if(JsonType::Object != type() && JsonType::Array != type()) {
+        return 0;
+    }
+    return values_[value_].size_;
+}
+
+JsonProxy JsonProxy::at(uint64_t index) const
+{
+    CPPJSON_ASSERT(JsonReader::Invalid != value_);
+    if(JsonType::Array != type()) {
+        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
+    }
+    uint32_t value = reader_->at(static_cast<uint32_t>(value_), index);
+    if(JsonReader::Invalid == value) {
+        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
+    }
+    return {value, data_, values_, numbers_, reader_};
+}
+
+JsonCursor::operator bool() const
+{
+    return JsonType::Invalid != type_;
+}
+
+JsonType JsonCursor::type() const
+{
+    return type_;
+}
+
+uint64_t JsonCursor::size() const
+{
+    CPPJSON_ASSERT(JsonType::Invalid != type_);
+    switch(type_) {
+    case JsonType::Object:
+    case JsonType::Array:
+        return count();
+    case JsonType::String: {
+        const char* next = skip_string(str_, end_);
+        return CPPJSON_NULL != next ? static_cast<uint64_t>(next - str_) - 2 : 0;
+    }
+    default:
+        return static_cast<uint64_t>(skip_token(str_, end_) - str_);
+    }
+}
+
+JsonCursor JsonCursor::begin() const
+{
+    CPPJSON_ASSERT(JsonType::Invalid != type_);
+    if(JsonType::Object != type_ && JsonType::Array != type_) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    const char* str = skip_whitespace(str_ + 1, end_);
+    if(end_ <= str || ('}' == str[0] && JsonType::Object == type_) || (']' == str[0] && JsonType::Array == type_)) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    if(JsonType::Object == type_) {
+        if('"' != str[0]) {
+            return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+        }
+        return {str, end_, JsonType::KeyValue};
+    }
+    return {str, end_, JsonType::ArrayValue};
+}
+
+JsonCursor JsonCursor::next() const
+{
+    CPPJSON_ASSERT(JsonType::Invalid != type_);
+    if(JsonType::KeyValue != type_ && JsonType::ArrayValue != type_) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    JsonCursor current = value();
+    const char* str = current ? skip_value(current.str_, end_) : CPPJSON_NULL;
+    if(CPPJSON_NULL == str) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    str = skip_whitespace(str, end_);
+    if(end_ <= str || ',' != str[0]) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    str = skip_whitespace(str + 1, end_);
+    if(end_ <= str || (JsonType::KeyValue == type_ && '"' != str[0])) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    return {str, end_, type_};
+}
+
+JsonCursor JsonCursor::key() const
+{
+    CPPJSON_ASSERT(JsonType::Invalid != type_);
+    if(JsonType::KeyValue != type_) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    return {str_, end_, JsonType::String};
+}
+
+JsonCursor JsonCursor::value() const
+{
+    CPPJSON_ASSERT(JsonType::Invalid != type_);
+    if(JsonType::ArrayValue == type_) {
+        return make_cursor(str_, end_);
+    }
+    if(JsonType::KeyValue != type_) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    const char* str = skip_string(str_, end_);
+    if(CPPJSON_NULL == str) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    str = skip_whitespace(str, end_);
+    if(end_ <= str || ':' != str[0]) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    return make_cursor(skip_whitespace(str + 1, end_), end_);
+}
+
+uint64_t JsonCursor::getString(char* str) const
+{
+    uint64_t length = size();
+    ::memcpy(str, str_ + 1, length);
+    str[length] = '\0';
+    return length;
+}
+
+int64_t JsonCursor::getInt64() const
+{
+    int64_t value = 0;
+    std::from_chars(str_, skip_token(str_, end_), value);
+    return value;
+}
+
+uint64_t JsonCursor::getUInt64() const
+{
+    uint64_t value = 0;
+    std::from_chars(str_, skip_token(str_, end_), value);
+    return value;
+}
+
+double JsonCursor::getFloat64() const
+{
+    return decode_float(str_, skip_token(str_, end_));
+}
+
+bool JsonCursor::compareKey(std::string_view str) const
+{
+    CPPJSON_ASSERT(JsonType::Invalid != type_);
+    if(JsonType::KeyValue != type_) {
+        return false;
+    }
+    const char* next = skip_string(str_, end_);
+    return CPPJSON_NULL != next && str.size() == static_cast<uint64_t>(next - str_ - 2) && 0 == ::memcmp(str_ + 1, str.data(), str.size());
+}
+
+JsonCursor JsonCursor::find(std::string_view key) const
+{
+    CPPJSON_ASSERT(JsonType::Invalid != type_);
+    if(JsonType::Object != type_) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    for(JsonCursor i = begin(); i; i = i.next()) {
+        if(i.compareKey(key)) {
+            return i.value();
+        }
+    }
+    return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+}
+
+uint64_t JsonCursor::count() const
+{
+    CPPJSON_ASSERT(JsonType::Invalid != type_);
+    uint64_t count = 0;
+    if(JsonType::Object == type_ || JsonType::Array == type_) {
+        JsonCursor last = {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+        for(JsonCursor i = begin(); i; i = i.next()) {
+            last = i;
+            ++count;
+        }
+        // The walk stops at the closing or at a malformed entry or separator
+        if(last) {
+            JsonCursor value = last.value();
+            const char* str = value ? skip_value(value.str_, end_) : CPPJSON_NULL;
+            str = CPPJSON_NULL != str ? skip_whitespace(str, end_) : CPPJSON_NULL;
+            if(CPPJSON_NULL == str || end_ <= str || (JsonType::Object == type_ ? '}' : ']') != str[0]) {
+                return 0;
+            }
+        }
+    }
+    return count;
+}
+
+JsonCursor JsonCursor::at(uint64_t index) const
+{
+    CPPJSON_ASSERT(JsonType::Invalid != type_);
+    if(JsonType::Array != type_) {
+        return {CPPJSON_NULL, CPPJSON_NULL, JsonType::Invalid};
+    }
+    JsonCursor i = begin();
+    for(; i && 0 < index; --index) {
+        i = i.next();
+    }
+    return i ? i.value() : i;
+}
+
+JsonArena::JsonArena(uint64_t chunk_size, CPPJSON_MALLOC_TYPE alloc, CPPJSON_FREE_TYPE dealloc)
+    : alloc_(alloc)
+    , dealloc_(dealloc)
+    , chunk_size_(chunk_size)
+    , size_(0)
+    , capacity_(0)
+    , chunks_(CPPJSON_NULL)
+    , top_(CPPJSON_NULL)
+    , end_(CPPJSON_NULL)
+    , last_(CPPJSON_NULL)
+{
+    if(CPPJSON_NULL == alloc_ || CPPJSON_NULL == dealloc_) {
+        alloc_ = ::malloc;
+        dealloc_ = ::free;
+    }
+}
+
+JsonArena::~JsonArena()
+{
+    release();
+}
+
+JsonAllocator JsonArena::allocator()
+{
+    return {arena_allocate, arena_deallocate, arena_reallocate, this};
+}
+
+void* JsonArena::allocate(size_t size)
+{
+    if((SIZE_MAX - Align) < size) {
+        return CPPJSON_NULL;
+    }
+    uint64_t aligned = (static_cast<uint64_t>(size) + (Align - 1)) & ~(Align - 1);
+    if(static_cast<uint64_t>(end_ - top_) < aligned && !expand(aligned)) {
+        return CPPJSON_NULL;
+    }
+    last_ = top_;
+    top_ += aligned;
+    size_ += aligned;
+    return last_;
+}
+
+void JsonArena::deallocate(void* ptr)
+{
+    if(CPPJSON_NULL != ptr && ptr == last_) {
+        size_ -= static_cast<uint64_t>(top_ - last_);
+        top_ = last_;
+        last_ = CPPJSON_NULL;
+    }
+}
+
+void* JsonArena::reallocate(void* ptr, size_t size, size_t new_size)
+{
+    if(CPPJSON_NULL == ptr) {
+        return allocate(new_size);
+    }
+    if((SIZE_MAX - Align) < new_size) {
+        return CPPJSON_NULL;
+    }
+    uint64_t aligned = (static_cast<uint64_t>(new_size) + (Align - 1)) & ~(Align - 1);
+    if(ptr == last_) {
+        if(aligned <= static_cast<uint64_t>(end_ - last_)) {
+            size_ = size_ - static_cast<uint64_t>(top_ - last_) + aligned;
+            top_ = last_ + aligned;
+            return ptr;
+        }
+    } else if(new_size <= size) {
+        return ptr;
+    }
+    void* result = allocate(new_size);
+    if(CPPJSON_NULL == result) {
+        return CPPJSON_NULL;
+    }
+    ::memcpy(result, ptr, size < new_size ? size : new_size);
+    return result;
+}
+
+bool JsonArena::reset()
+{
+    // Merge chunks into one, so that the next round of the same allocations fits in it
+    if(CPPJSON_NULL != chunks_ && CPPJSON_NULL != chunks_->next_) {
+        uint64_t capacity = capacity_;
+        release();
+        if(!expand(capacity)) {
+            return false;
+        }
+    }
+    size_ = 0;
+    last_ = CPPJSON_NULL;
+    if(CPPJSON_NULL != chunks_) {
+        top_ = reinterpret_cast<char*>(chunks_ + 1);
+        end_ = top_ + chunks_->capacity_;
+    }
+    return true;
+}
+
+void JsonArena::release()
+{
+    while(CPPJSON_NULL != chunks_) {
+        Chunk* next = chunks_->next_;
+        dealloc_(chunks_);
+        chunks_ = next;
+    }
+    size_ = 0;
+    capacity_ = 0;
+    top_ = CPPJSON_NULL;
+    end_ = CPPJSON_NULL;
+    last_ = CPPJSON_NULL;
+}
+
+uint64_t JsonArena::size() const
+{
+    return size_;
+}
+
+uint64_t JsonArena::capacity() const
+{
+    return capacity_;
+}
+
+bool JsonArena::expand(uint64_t size)
+{
+    // Chunks grow twice, so that growing allocations stay in place
+    uint64_t capacity = CPPJSON_NULL != chunks_ ? chunks_->capacity_ * 2 : 0;
+    capacity = capacity < chunk_size_ ? chunk_size_ : capacity;
+    capacity = capacity < size ? size : capacity;
+    capacity = (capacity + (Align - 1)) & ~(Align - 1);
+    if((SIZE_MAX - sizeof(Chunk)) < capacity) {
+        return false;
+    }
+    Chunk* chunk = reinterpret_cast<Chunk*>(alloc_(static_cast<size_t>(sizeof(Chunk) + capacity)));
+    if(CPPJSON_NULL == chunk) {
+        return false;
+    }
+    chunk->next_ = chunks_;
+    chunk->capacity_ = capacity;
+    chunks_ = chunk;
+    capacity_ += capacity;
+    top_ = reinterpret_cast<char*>(chunk + 1);
+    end_ = top_ + capacity;
+    last_ = CPPJSON_NULL;
+    return true;
+}
+
+JsonPool::JsonPool(CPPJSON_MALLOC_TYPE alloc, CPPJSON_FREE_TYPE dealloc)
+    : alloc_(alloc)
+    , dealloc_(dealloc)
+    , cached_(0)
+{
+    if(CPPJSON_NULL == alloc_ || CPPJSON_NULL == dealloc_) {
+        alloc_ = ::malloc;
+        dealloc_ = ::free;
+    }
+    for(uint32_t i = 0; i < Classes; ++i) {
+        blocks_[i] = CPPJSON_NULL;
+    }
+}
+
+JsonPool::~JsonPool()
+{
+    trim();
+}
+
+JsonAllocator JsonPool::allocator()
+{
+    return {pool_allocate, pool_deallocate, pool_reallocate, this};
+}
+
+void* JsonPool::allocate(size_t size)
+{
+    if((SIZE_MAX - sizeof(Block)) < size) {
+        return CPPJSON_NULL;
+    }
+    uint32_t c = classify(size + sizeof(Block));
+    Block* block = c < Classes ? blocks_[c] : CPPJSON_NULL;
+    if(CPPJSON_NULL != block) {
+        blocks_[c] = block->next_;
+        cached_ -= MinSize << c;
+        return block + 1;
+    }
+    block = reinterpret_cast<Block*>(alloc_(c < Classes ? static_cast<size_t>(MinSize << c) : (size + sizeof(Block))));
+    if(CPPJSON_NULL == block) {
+        return CPPJSON_NULL;
+    }
+    block->class_ = c;
+    return block + 1;
+}
+
+void JsonPool::deallocate(void* ptr)
+{
+    if(CPPJSON_NULL == ptr) {
+        return;
+    }
+    Block* block = reinterpret_cast<Block*>(ptr) - 1;
+    if(Classes <= block->class_) {
+        dealloc_(block);
+        return;
+    }
+    block->next_ = blocks_[block->class_];
+    blocks_[block->class_] = block;
+    cached_ += MinSize << block->class_;
+}
+
+void* JsonPool::reallocate(void* ptr, size_t size, size_t new_size)
+{
+    if(CPPJSON_NULL == ptr) {
+        return allocate(new_size);
+    }
+    const Block* block = reinterpret_cast<const Block*>(ptr) - 1;
+    if(block->class_ < Classes && new_size <= ((MinSize << block->class_) - sizeof(Block))) {
+        return ptr;
+    }
+    void* result = allocate(new_size);
+    if(CPPJSON_NULL == result) {
+        return CPPJSON_NULL;
+    }
+    ::memcpy(result, ptr, size < new_size ? size : new_size);
+    deallocate(ptr);
+    return result;
+}
+
+void JsonPool::trim()
+{
+    for(uint32_t i = 0; i < Classes; ++i) {
+        while(CPPJSON_NULL != blocks_[i]) {
+            Block* next = blocks_[i]->next_;
+            dealloc_(blocks_[i]);
+            blocks_[i] = next;
+        }
+    }
+    cached_ = 0;
+}
+
+uint64_t JsonPool::cached() const
+{
+    return cached_;
+}
+
+uint32_t JsonPool::classify(uint64_t size)
+{
+    uint32_t c = 0;
+    while(c < Classes && (MinSize << c) < size) {
+        ++c;
+    }
+    return (c < Classes && (MinSize << c) <= SIZE_MAX) ? c : Classes;
+}
+
+JsonQuery::JsonQuery(CPPJSON_MALLOC_TYPE alloc, CPPJSON_FREE_TYPE dealloc, CPPJSON_REALLOC_TYPE realloc)
+    : JsonQuery(JsonFunctions{alloc, dealloc, realloc}, JsonAllocator{})
+{
+}
+
+JsonQuery::JsonQuery(const JsonAllocator& allocator)
+    : JsonQuery(JsonFunctions{}, allocator)
+{
+}
+
+JsonQuery::JsonQuery(const JsonFunctions& functions, const JsonAllocator& allocator)
+    : functions_(functions)
+    , allocator_(allocator)
+    , paths_(0)
+    , node_capacity_(0)
+    , node_size_(0)
+    , nodes_(CPPJSON_NULL)
+    , token_capacity_(0)
+    , token_size_(0)
+    , tokens_(CPPJSON_NULL)
+{
+    if(CPPJSON_NULL == allocator_.allocate_ || CPPJSON_NULL == allocator_.deallocate_) {
+        allocator_ = make_allocator(functions_);
+    }
+    clear();
+}
+
+JsonQuery::~JsonQuery()
+{
+    deallocate(tokens_);
+    tokens_ = CPPJSON_NULL;
+    deallocate(nodes_);
+    nodes_ = CPPJSON_NULL;
+}
+
+uint32_t JsonQuery::add(std::string_view path)
+{
+    if(node_size_ <= 0) {
+        return Invalid;
+    }
+    bool pointer = !path.empty() && '/' == path[0];
+    char separator = pointer ? '/' : '.';
+    uint64_t position = pointer ? 1 : 0;
+    uint32_t node = 0;
+    while(!path.empty() && position <= path.size()) {
+        uint64_t last = path.find(separator, position);
+        last = std::string_view::npos == last ? path.size() : last;
+
+        // Unescape the token into the end of tokens, which is kept only if the token is new
+        uint64_t size = last - position;
+        if((Invalid - token_size_) <= size) {
+            return Invalid;
+        }
+        if(token_capacity_ < (token_size_ + size)) {
+            uint32_t capacity = static_cast<uint32_t>(token_size_ + size) + (token_capacity_ >> 1) + 64;
+            char* tokens = reinterpret_cast<char*>(reallocate(tokens_, token_size_, capacity));
+            if(CPPJSON_NULL == tokens) {
+                return Invalid;
+            }
+            tokens_ = tokens;
+            token_capacity_ = capacity;
+        }
+        char* token = tokens_ + token_size_;
+        size = 0;
+        for(uint64_t i = position; i < last; ++i) {
+            if(pointer && '~' == path[i]) {
+                ++i;
+                if(last <= i || ('0' != path[i] && '1' != path[i])) {
+                    return Invalid;
+                }
+                token[size] = '0' == path[i] ? '~' : '/';
+            } else {
+                token[size] = path[i];
+            }
+            ++size;
+        }
+        node = insert(node, token, size, 1 == (last - position) && '*' == path[position]);
+        if(Invalid == node) {
+            return Invalid;
+        }
+        position = last + 1;
+    }
+    if(Invalid == nodes_[node].path_) {
+        nodes_[node].path_ = paths_;
+        ++paths_;
+    }
+    return nodes_[node].path_;
+}
+
+uint32_t JsonQuery::size() const
+{
+    return paths_;
+}
+
+void JsonQuery::clear()
+{
+    paths_ = 0;
+    node_size_ = 0;
+    token_size_ = 0;
+    insert(Invalid, CPPJSON_NULL, 0, false);
+}
+
+void* JsonQuery::allocate(size_t size) const
+{
+    return allocator_.allocate_(allocator_.context_, size);
+}
+
+void JsonQuery::deallocate(void* ptr) const
+{
+    allocator_.deallocate_(allocator_.context_, ptr);
+}
+
+void* JsonQuery::reallocate(void* ptr, size_t size, size_t new_size) const
+{
+    if(CPPJSON_NULL != allocator_.reallocate_) {
+        return allocator_.reallocate_(allocator_.context_, ptr, size, new_size);
+    }
+    void* result = allocate(new_size);
+    if(CPPJSON_NULL == result) {
+        return CPPJSON_NULL;
+    }
+    if(0 < size) {
+        ::memcpy(result, ptr, size);
+    }
+    deallocate(ptr);
+    return result;
+}
+
+uint32_t JsonQuery::insert(uint32_t parent, const char* token, uint64_t size, bool wildcard)
+{
+    // The token is at the end of tokens
+    uint32_t last = Invalid;
+    if(Invalid != parent) {
+        for(uint32_t child = nodes_[parent].child_; Invalid != child; child = nodes_[child].sibling_) {
+            const Node& node = nodes_[child];
+            if(wildcard == node.wildcard_ && size == node.token_size_ && (0 == size || 0 == ::memcmp(tokens_ + node.token_, token, size))) {
+                return child;
+            }
+            last = child;
+        }
+    }
+    if(node_capacity_ <= node_size_) {
+        uint32_t capacity = node_capacity_ + (node_capacity_ >> 1) + 16;
+        Node* nodes = reinterpret_cast<Node*>(reallocate(nodes_, sizeof(Node) * node_size_, sizeof(Node) * capacity));
+        if(CPPJSON_NULL == nodes) {
+            return Invalid;
+        }
+        nodes_ = nodes;
+        node_capacity_ = capacity;
+    }
+
+    // Decimal tokens without leading zeros are also indices of arrays
+    uint64_t index = (0 < size && size <= 9 && ('0' != token[0] || 1 == size)) ? 0 : Invalid;
+    for(uint64_t i = 0; i < size && Invalid != index; ++i) {
+        index = ('0' <= token[i] && token[i] <= '9') ? index * 10 + static_cast<uint64_t>(token[i] - '0') : Invalid;
+    }
+    uint32_t node = node_size_;
+    nodes_[node] = {token_size_, static_cast<uint32_t>(size), static_cast<uint32_t>(index), Invalid, Invalid, Invalid, wildcard};
+    ++node_size_;
+    token_size_ += static_cast<uint32_t>(size);
+    if(Invalid != last) {
+        nodes_[last].sibling_ = node;
+    } else if(Invalid != parent) {
+        nodes_[parent].child_ = node;
+    }
+    return node;
+}
+
+bool JsonQuery::matches(uint32_t node, const char* key, uint64_t size) const
+{
+    const Node& query_node = nodes_[node];
+    return query_node.wildcard_ || (size == query_node.token_size_ && (0 == size || 0 == ::memcmp(tokens_ + query_node.token_, key, size)));
+}
+
+JsonReader::JsonReader(int32_t max_nesting, CPPJSON_MALLOC_TYPE alloc, CPPJSON_FREE_TYPE dealloc, CPPJSON_REALLOC_TYPE realloc)
+    : JsonReader(max_nesting, JsonFunctions{alloc, dealloc, realloc}, JsonAllocator{})
+{
+}
+
+JsonReader::JsonReader(int32_t max_nesting, const JsonAllocator& allocator)
+    : JsonReader(max_nesting, JsonFunctions{}, allocator)
+{
+}
+
+JsonReader::JsonReader(int32_t max_nesting, const JsonFunctions& functions, const JsonAllocator& allocator)
+    : functions_(functions)
+    , allocator_(allocator)
+    , max_nesting_(max_nesting)
+    , nesting_(0)
+    , stack_budget_(StackBudget)
+    , expand_(Expand)
+    , growth_(Growth)
+    , capacity_(0)
+    , size_(0)
+    , values_(CPPJSON_NULL)
+    , indexing_(false)
+    , indexed_(false)
+    , structural_capacity_(0)
+    , structural_size_(0)
+    , structural_(0)
+    , structurals_(CPPJSON_NULL)
+    , special_capacity_(0)
+    , specials_(CPPJSON_NULL)
+    , decoding_(false)
+    , number_capacity_(0)
+    , number_size_(0)
+    , numbers_(CPPJSON_NULL)
+    , table_capacity_(0)
+    , table_size_(0)
+    , tables_(CPPJSON_NULL)
+    , stream_capacity_(0)
+    , stream_size_(0)
+    , stream_offset_(0)
+    , stream_scan_(0)
+    , stream_(CPPJSON_NULL)
+    , expect_(Expect::Error)
+    , frame_capacity_(0)
+    , frame_size_(0)
+    , frames_(CPPJSON_NULL)
+    , mapping_(CPPJSON_NULL)
+    , mapping_size_(0)
+    , file_(CPPJSON_NULL)
+    , index_(CPPJSON_NULL)
+    , index_size_(0)
+    , query_(CPPJSON_NULL)
+    , state_capacity_(0)
+    , state_size_(0)
+    , states_(CPPJSON_NULL)
+    , match_capacity_(0)
+    , match_size_(0)
+    , matches_(CPPJSON_NULL)
+    , projection_(CPPJSON_NULL)
+    , projecting_(false)
+    , projected_(false)
+    , state_first_(0)
+    , state_count_(0)
+    , error_(JsonError::None)
+    , error_at_(CPPJSON_NULL)
+{
+    CPPJSON_ASSERT(0 < max_nesting_);
+    if(CPPJSON_NULL == allocator_.allocate_ || CPPJSON_NULL == allocator_.deallocate_) {
+        allocator_ = make_allocator(functions_);
+    }
+    CPPJSON_ASSERT(CPPJSON_NULL != allocator_.allocate_);
+    CPPJSON_ASSERT(CPPJSON_NULL != allocator_.deallocate_);
+}
+
+JsonReader::~JsonReader()
+{
+    release();
+    deallocate(matches_);
+    matches_ = CPPJSON_NULL;
+    deallocate(states_);
+    states_ = CPPJSON_NULL;
+    deallocate(frames_);
+    frames_ = CPPJSON_NULL;
+    deallocate(stream_);
+    stream_ = CPPJSON_NULL;
+    deallocate(tables_);
+    tables_ = CPPJSON_NULL;
+    deallocate(numbers_);
+    numbers_ = CPPJSON_NULL;
+    deallocate(specials_);
+    specials_ = CPPJSON_NULL;
+    deallocate(structurals_);
+    structurals_ = CPPJSON_NULL;
+    deallocate(values_);
+    values_ = CPPJSON_NULL;
+}
+
+void JsonReader::setGrowth(uint32_t expand, uint32_t percent)
+{
+    expand_ = 0 < expand ? expand : 1;
+    growth_ = percent;
+}
+
+void JsonReader::setStackBudget(uint64_t bytes)
+{
+    stack_budget_ = bytes;
+}
+
+bool JsonReader::reserve(uint64_t capacity)
+{
+    // Loaded elements are not resized, those are released
+    if(CPPJSON_NULL != index_) {
+        release();
+    }
+    if(capacity <= capacity_) {
+        return true;
+    }
+    return expand(capacity);
+}
+
+uint32_t JsonReader::capacity() const
+{
+    return capacity_;
+}
+
+void JsonReader::shrink(uint64_t bytes)
+{
+    release();
+    clear();
+    structural_size_ = 0;
+    stream_size_ = 0;
+    state_size_ = 0;
+    if(bytes < sizeof(JsonValue) * capacity_) {
+        deallocate(values_);
+        values_ = CPPJSON_NULL;
+        capacity_ = 0;
+    }
+    if(bytes < sizeof(uint32_t) * structural_capacity_) {
+        deallocate(structurals_);
+        structurals_ = CPPJSON_NULL;
+        structural_capacity_ = 0;
+    }
+    if(bytes < sizeof(uint64_t) * special_capacity_) {
+        deallocate(specials_);
+        specials_ = CPPJSON_NULL;
+        special_capacity_ = 0;
+    }
+    if(bytes < sizeof(JsonNumber) * number_capacity_) {
+        deallocate(numbers_);
+        numbers_ = CPPJSON_NULL;
+        number_capacity_ = 0;
+    }
+    if(bytes < sizeof(uint32_t) * table_capacity_) {
+        deallocate(tables_);
+        tables_ = CPPJSON_NULL;
+        table_capacity_ = 0;
+    }
+    if(bytes < stream_capacity_) {
+        deallocate(stream_);
+        stream_ = CPPJSON_NULL;
+        stream_capacity_ = 0;
+    }
+    if(bytes < sizeof(Frame) * frame_capacity_) {
+        deallocate(frames_);
+        frames_ = CPPJSON_NULL;
+        frame_capacity_ = 0;
+    }
+    if(bytes < sizeof(uint32_t) * state_capacity_) {
+        deallocate(states_);
+        states_ = CPPJSON_NULL;
+        state_capacity_ = 0;
+    }
+    if(bytes < sizeof(Match) * match_capacity_) {
+        deallocate(matches_);
+        matches_ = CPPJSON_NULL;
+        match_capacity_ = 0;
+    }
+}
+
+uint64_t JsonReader::memory() const
+{
+    uint64_t bytes = CPPJSON_NULL != index_ ? 0 : (sizeof(JsonValue) * capacity_ + sizeof(JsonNumber) * number_capacity_);
+    bytes += sizeof(uint32_t) * structural_capacity_;
+    bytes += sizeof(uint64_t) * special_capacity_;
+    bytes += sizeof(uint32_t) * table_capacity_;
+    bytes += stream_capacity_;
+    bytes += sizeof(Frame) * frame_capacity_;
+    bytes += sizeof(uint32_t) * state_capacity_;
+    bytes += sizeof(Match) * match_capacity_;
+    return bytes;
+}
+
+uint64_t JsonReader::estimate(const char* begin, const char* end)
+{
+    CPPJSON_ASSERT(begin <= end);
+    // Each member or element adds at most three elements, a pair, a key and a value.
+    // The count of them is bounded by the count of commas and openings.
+    uint64_t count = 0;
+    for(const char* str = begin; str < end; ++str) {
+        count += (',' == str[0]) | ('{' == str[0]) | ('[' == str[0]);
+    }
+    return count * 3 + 1;
+}
+
+void JsonReader::setStructuralIndex(bool enable)
+{
+    indexing_ = enable;
+}
+
+void JsonReader::setNumberDecoding(bool enable)
+{
+    decoding_ = enable;
+}
+
+void JsonReader::setProjection(const JsonQuery* projection)
+{
+    projection_ = projection;
+}
+
+bool JsonReader::parse(const char* begin, const char* end)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    release();
+    begin_ = begin;
+    end_ = end;
+    nesting_ = 0;
+    frame_size_ = 0;
+    size_ = 0;
+    number_size_ = 0;
+    table_size_ = 0;
+    match_size_ = 0;
+    if(MaxSize < static_cast<uint64_t>(end - begin)) {
+        return false;
+    }
+    indexed_ = indexing_ && index();
+
+    // The root is stored, and the projection starts at its members or elements
+    if(CPPJSON_NULL != projection_ && JsonQuery::Invalid == projection_->nodes_[0].path_) {
+        query_ = projection_;
+        state_size_ = 0;
+        state_first_ = 0;
+        state_count_ = 1;
+        projecting_ = push_state(0);
+        if(!projecting_) {
+            return false;
+        }
+    }
+    projected_ = projecting_;
+    const char* str = parse_element(begin_);
+    projecting_ = false;
+    query_ = CPPJSON_NULL;
+    if(CPPJSON_NULL == str) {
+        return false;
+    }
+    str = whitespace(str);
+    return end_ <= str;
+}
+
+bool JsonReader::parse(const char* begin, const char* end, const JsonQuery& query)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    release();
+    begin_ = begin;
+    end_ = end;
+    nesting_ = 0;
+    frame_size_ = 0;
+    size_ = 0;
+    number_size_ = 0;
+    table_size_ = 0;
+    match_size_ = 0;
+    indexed_ = false;
+    projected_ = false;
+    if(MaxSize < static_cast<uint64_t>(end - begin)) {
+        return false;
+    }
+    query_ = &query;
+    state_size_ = 0;
+    const char* str = push_state(0) ? parse_query_value(skip_whitespace(begin_, end_), 0, 1) : CPPJSON_NULL;
+    query_ = CPPJSON_NULL;
+    if(CPPJSON_NULL == str) {
+        return false;
+    }
+    str = skip_whitespace(str, end_);
+    return end_ <= str;
+}
+
+struct JsonReader::Validation
+{
+    bool on_object_begin()
+    {
+        return true;
+    }
+
+    bool on_object_end(uint64_t)
+    {
+        return true;
+    }
+
+    bool on_array_begin()
+    {
+        return true;
+    }
+
+    bool on_array_end(uint64_t)
+    {
+        return true;
+    }
+
+    bool on_key(std::string_view)
+    {
+        return true;
+    }
+
+    bool on_string(std::string_view)
+    {
+        return true;
+    }
+
+    bool on_int(int64_t)
+    {
+        return true;
+    }
+
+    bool on_uint(uint64_t)
+    {
+        return true;
+    }
+
+    bool on_double(double)
+    {
+        return true;
+    }
+
+    bool on_bool(bool)
+    {
+        return true;
+    }
+
+    bool on_null()
+    {
+        return true;
+    }
+};
+
+JsonStatus JsonReader::validate(const char* begin, const char* end)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    // The events drive the grammar, and the handler accepts all of them, so that only an error of the document stops them
+    Validation validation;
+    parse(begin, end, validation);
+    frame_size_ = 0;
+    indexed_ = false;
+    return {error_, static_cast<uint64_t>(error_at_ - begin_)};
+}
+
+uint64_t JsonReader::matches() const
+{
+    return match_size_;
+}
+
+JsonProxy JsonReader::match(uint64_t index) const
+{
+    CPPJSON_ASSERT(index < match_size_);
+    return {matches_[index].value_, begin_, values_, numbers_, this};
+}
+
+uint32_t JsonReader::matchPath(uint64_t index) const
+{
+    CPPJSON_ASSERT(index < match_size_);
+    return matches_[index].path_;
+}
+
+bool JsonReader::parseFile(const char* path)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != path);
+    release();
+    uint64_t size;
+    bool mapped;
+    char* data = read_file(path, size, mapped);
+    if(CPPJSON_NULL == data) {
+        return false;
+    }
+#ifdef CPPJSON_MMAP
+    if(mapped) {
+        ::madvise(data, static_cast<size_t>(size), MADV_SEQUENTIAL);
+    }
+#endif // CPPJSON_MMAP
+    bool result = parse(data, data + size);
+    if(mapped) {
+#ifdef CPPJSON_MMAP
+        // Elements are accessed at random after parsing
+        ::madvise(data, static_cast<size_t>(size), MADV_NORMAL);
+#endif // CPPJSON_MMAP
+        mapping_ = data;
+        mapping_size_ = size;
+    } else {
+        file_ = data;
+    }
+    return result;
+}
+
+bool JsonReader::saveIndex(const char* path) const
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != path);
+    if(size_ <= 0) {
+        return false;
+    }
+    IndexHeader header = {};
+    ::memcpy(header.magic_, "CPPJSON", 8);
+    header.version_ = IndexVersion;
+    header.value_size_ = sizeof(JsonValue);
+    header.source_size_ = static_cast<uint64_t>(end_ - begin_);
+    header.source_hash_ = hash_document(begin_, end_);
+    header.values_ = size_;
+    header.numbers_ = number_size_;
+    header.flags_ = projected_ ? IndexProjected : 0;
+    FILE* file = ::fopen(path, "wb");
+    if(CPPJSON_NULL == file) {
+        return false;
+    }
+    bool result = 1 == ::fwrite(&header, sizeof(IndexHeader), 1, file);
+
+    // Tables are caches, which are dropped from copies of the elements, so that the reader is not modified while others look up
+    static constexpr uint32_t BlockSize = 256;
+    JsonValue block[BlockSize];
+    for(uint32_t i = 0; result && i < size_; i += BlockSize) {
+        uint32_t count = (size_ - i) < BlockSize ? size_ - i : BlockSize;
+        for(uint32_t j = 0; j < count; ++j) {
+            uint32_t value = i + j;
+            block[j] = values_[value];
+            block[j].flags_ &= ~JsonValue::Indexed;
+            if(1 <= value && 0 != (values_[value - 1].flags_ & JsonValue::Indexed) && static_cast<uint32_t>(JsonType::Array) == values_[value - 1].type_) {
+                block[j].start_ = Invalid;
+            }
+            if(2 <= value && 0 != (values_[value - 2].flags_ & JsonValue::Indexed) && static_cast<uint32_t>(JsonType::Object) == values_[value - 2].type_) {
+                block[j].next_ = Invalid;
+            }
+        }
+        result = count == ::fwrite(block, sizeof(JsonValue), count, file);
+    }
+    result = result && (number_size_ <= 0 || number_size_ == ::fwrite(numbers_, sizeof(JsonNumber), number_size_, file));
+    return 0 == ::fclose(file) && result;
+}
+
+bool JsonReader::loadIndex(const char* path, const char* begin, const char* end)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != path);
+    CPPJSON_ASSERT(begin <= end);
+    release();
+    return load_index(path, begin, end);
+}
+
+bool JsonReader::loadFile(const char* path, const char* index_path)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != path);
+    CPPJSON_ASSERT(CPPJSON_NULL != index_path);
+    release();
+    uint64_t size;
+    bool mapped;
+    char* data = read_file(path, size, mapped);
+    if(CPPJSON_NULL == data) {
+        return false;
+    }
+    if(mapped) {
+        mapping_ = data;
+        mapping_size_ = size;
+    } else {
+        file_ = data;
+    }
+    return load_index(index_path, data, data + size);
+}
+
+void JsonReader::release()
+{
+#ifdef CPPJSON_MMAP
+    if(CPPJSON_NULL != mapping_) {
+        ::munmap(mapping_, static_cast<size_t>(mapping_size_));
+    }
+#endif // CPPJSON_MMAP
+    mapping_ = CPPJSON_NULL;
+    mapping_size_ = 0;
+    deallocate(file_);
+    file_ = CPPJSON_NULL;
+#ifdef CPPJSON_MMAP
+    if(CPPJSON_NULL != index_) {
+        ::munmap(index_, static_cast<size_t>(index_size_));
+        // The elements and the numbers were in the mapping
+        capacity_ = 0;
+        size_ = 0;
+        values_ = CPPJSON_NULL;
+        number_capacity_ = 0;
+        number_size_ = 0;
+        numbers_ = CPPJSON_NULL;
+    }
+#endif // CPPJSON_MMAP
+    index_ = CPPJSON_NULL;
+    index_size_ = 0;
+}
+
+char* JsonReader::read_file(const char* path, uint64_t& size, bool& mapped)
+{
+#ifdef CPPJSON_MMAP
+    int descriptor = ::open(path, O_RDONLY | O_CLOEXEC);
+    if(descriptor < 0) {
+        return CPPJSON_NULL;
+    }
+    struct stat status;
+    if(0 == ::fstat(descriptor, &status) && S_ISREG(status.st_mode) && 0 < status.st_size) {
+        size = static_cast<uint64_t>(status.st_size);
+        void* mapping = SIZE_MAX < size ? MAP_FAILED : ::mmap(CPPJSON_NULL, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        ::close(descriptor);
+        mapped = true;
+        return MAP_FAILED == mapping ? CPPJSON_NULL : static_cast<char*>(mapping);
+    }
+    FILE* file = ::fdopen(descriptor, "rb");
+    if(CPPJSON_NULL == file) {
+        ::close(descriptor);
+        return CPPJSON_NULL;
+    }
+#else
+    FILE* file = ::fopen(path, "rb");
+    if(CPPJSON_NULL == file) {
+        return CPPJSON_NULL;
+    }
+#endif // CPPJSON_MMAP
+
+    // The size is unknown, read until the end doubling the buffer
+    uint64_t capacity = 0;
+    char* buffer = CPPJSON_NULL;
+    size = 0;
+    mapped = false;
+    for(;;) {
+        if(capacity <= size) {
+            uint64_t new_capacity = capacity < 4096 ? 4096 : capacity * 2;
+            char* new_buffer = SIZE_MAX < new_capacity ? CPPJSON_NULL : reinterpret_cast<char*>(reallocate(buffer, static_cast<size_t>(size), static_cast<size_t>(new_capacity)));
+            if(CPPJSON_NULL == new_buffer) {
+                deallocate(buffer);
+                ::fclose(file);
+                return CPPJSON_NULL;
+            }
+            buffer = new_buffer;
+            capacity = new_capacity;
+        }
+        size_t read = ::fread(buffer + size, 1, static_cast<size_t>(capacity - size), file);
+        if(0 == read) {
+            break;
+        }
+        size += read;
+    }
+    bool failed = 0 != ::ferror(file);
+    ::fclose(file);
+    if(failed) {
+        deallocate(buffer);
+        return CPPJSON_NULL;
+    }
+    return buffer;
+}
+
+bool JsonReader::load_index(const char* path, const char* begin, const char* end)
+{
+    IndexHeader header;
+#ifdef CPPJSON_MMAP
+    int descriptor = ::open(path, O_RDONLY | O_CLOEXEC);
+    if(descriptor < 0) {
+        return false;
+    }
+    struct stat status;
+    void* mapping = MAP_FAILED;
+    uint64_t size = 0;
+    if(0 == ::fstat(descriptor, &status) && S_ISREG(status.st_mode) && sizeof(IndexHeader) <= static_cast<uint64_t>(status.st_size)) {
+        // Pages are copied on write, since tables built on the first access mark the elements
+        size = static_cast<uint64_t>(status.st_size);
+        mapping = SIZE_MAX < size ? MAP_FAILED : ::mmap(CPPJSON_NULL, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+    }
+    ::close(descriptor);
+    if(MAP_FAILED == mapping) {
+        return false;
+    }
+    ::memcpy(&header, mapping, sizeof(IndexHeader));
+#else
+    FILE* file = ::fopen(path, "rb");
+    if(CPPJSON_NULL == file) {
+        return false;
+    }
+    if(1 != ::fread(&header, sizeof(IndexHeader), 1, file)) {
+        ::fclose(file);
+        return false;
+    }
+#endif // CPPJSON_MMAP
+    uint64_t source_size = static_cast<uint64_t>(end - begin);
+    uint64_t index_size = sizeof(IndexHeader) + sizeof(JsonValue) * static_cast<uint64_t>(header.values_) + sizeof(JsonNumber) * static_cast<uint64_t>(header.numbers_);
+    bool valid = 0 == ::memcmp(header.magic_, "CPPJSON", 8) && IndexVersion == header.version_ && sizeof(JsonValue) == header.value_size_;
+    valid = valid && 0 < header.values_ && header.values_ < Invalid && source_size == header.source_size_ && hash_document(begin, end) == header.source_hash_;
+#ifdef CPPJSON_MMAP
+    valid = valid && size == index_size;
+    const JsonValue* values = reinterpret_cast<const JsonValue*>(static_cast<char*>(mapping) + sizeof(IndexHeader));
+    if(!valid || !check_index(values, header.values_, header.numbers_, source_size)) {
+        ::munmap(mapping, static_cast<size_t>(size));
+        return false;
+    }
+    deallocate(values_);
+    deallocate(numbers_);
+    index_ = mapping;
+    index_size_ = size;
+    values_ = reinterpret_cast<JsonValue*>(static_cast<char*>(mapping) + sizeof(IndexHeader));
+    numbers_ = reinterpret_cast<JsonNumber*>(values_ + header.values_);
+    capacity_ = 0;
+    number_capacity_ = 0;
+#else
+    (void)index_size;
+    size_ = 0;
+    number_size_ = 0;
+    valid = valid && (header.values_ <= capacity_ || expand(header.values_)) && header.values_ == ::fread(values_, sizeof(JsonValue), header.values_, file);
+    if(valid && number_capacity_ < header.numbers_) {
+        JsonNumber* numbers = reinterpret_cast<JsonNumber*>(reallocate(numbers_, 0, sizeof(JsonNumber) * header.numbers_));
+        valid = CPPJSON_NULL != numbers;
+        if(valid) {
+            numbers_ = numbers;
+            number_capacity_ = header.numbers_;
+        }
+    }
+    valid = valid && (header.numbers_ <= 0 || header.numbers_ == ::fread(numbers_, sizeof(JsonNumber), header.numbers_, file));
+    valid = valid && EOF == ::fgetc(file) && check_index(values_, header.values_, header.numbers_, source_size);
+    ::fclose(file);
+    if(!valid) {
+        return false;
+    }
+#endif // CPPJSON_MMAP
+    begin_ = begin;
+    end_ = end;
+    nesting_ = 0;
+    size_ = header.values_;
+    number_size_ = header.numbers_;
+    table_size_ = 0;
+    match_size_ = 0;
+    indexed_ = false;
+    projected_ = 0 != (header.flags_ & IndexProjected);
+    expect_ = Expect::Error;
+    frame_size_ = 0;
+    return true;
+}
+
+bool JsonReader::check_index(const JsonValue* values, uint32_t size, uint32_t numbers, uint64_t source)
+{
+    // Links point forward inside of the elements, so that walks terminate, and positions are inside of the document
+    static constexpr uint32_t Flags = JsonValue::Decoded | JsonValue::UInt64 | JsonValue::Overflow | JsonValue::Escaped;
+    uint64_t entries = 0;
+    for(uint32_t i = 0; i < size; ++i) {
+        const JsonValue& value = values[i];
+        if(0 != (value.flags_ & ~Flags)) {
+            return false;
+        }
+        switch(static_cast<JsonType>(value.type_)) {
+        case JsonType::Object:
+        case JsonType::Array: {
+            // Entries are chained between the aggregation and the end of descendants, as many as the size
+            if(source <= value.start_ || 0 != value.flags_ || value.next_ <= i || size < value.next_) {
+                return false;
+            }
+            uint32_t type = static_cast<uint32_t>(JsonType::Object == static_cast<JsonType>(value.type_) ? JsonType::KeyValue : JsonType::ArrayValue);
+            uint64_t count = 0;
+            for(uint32_t entry = 0 < value.size_ ? i + 1 : Invalid; Invalid != entry; entry = values[entry].next_) {
+                // Every entry is in one chain, so that all chains are walked in the number of elements
+                ++count;
+                ++entries;
+                if(value.next_ <= entry || type != values[entry].type_ || values[entry].next_ <= entry || size < entries) {
+                    return false;
+                }
+            }
+            if(count != value.size_) {
+                return false;
+            }
+        } break;
+        case JsonType::KeyValue:
+            if(value.start_ <= i || size <= value.start_ || static_cast<uint32_t>(JsonType::String) != values[value.start_].type_) {
+                return false;
+            }
+            // fall through
+        case JsonType::ArrayValue:
+            if(0 != value.flags_ || value.size_ <= i || size <= value.size_
+               || static_cast<uint32_t>(JsonType::KeyValue) == values[value.size_].type_ || static_cast<uint32_t>(JsonType::ArrayValue) == values[value.size_].type_) {
+                return false;
+            }
+            break;
+        case JsonType::String:
+        case JsonType::Number:
+        case JsonType::Integer:
+        case JsonType::True:
+        case JsonType::False:
+        case JsonType::Null:
+            if(source < value.start_ || (source - value.start_) < value.size_) {
+                return false;
+            }
+            if(0 != (value.flags_ & JsonValue::Decoded)
+               && ((static_cast<uint32_t>(JsonType::Number) != value.type_ && static_cast<uint32_t>(JsonType::Integer) != value.type_) || numbers <= value.next_)) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+void JsonReader::clear()
+{
+    nesting_ = 0;
+    frame_size_ = 0;
+    size_ = 0;
+    number_size_ = 0;
+    table_size_ = 0;
+    match_size_ = 0;
+    indexed_ = false;
+}
+
+uint32_t JsonReader::append(const char* data, const char* begin, const char* end)
+{
+    // Elements are appended after the ones of previous documents, with positions from data
+    if(MaxSize < static_cast<uint64_t>(end - data)) {
+        return Invalid;
+    }
+    begin_ = data;
+    end_ = end;
+    nesting_ = 0;
+    frame_size_ = 0;
+    uint32_t size = size_;
+    uint32_t number_size = number_size_;
+    const char* str = parse_element(begin);
+    if(CPPJSON_NULL == str || str < end_) {
+        size_ = size;
+        number_size_ = number_size;
+        return Invalid;
+    }
+    return size;
+}
+
+#ifndef CPPJSON_NO_THREADS
+bool JsonReader::parseParallel(const char* begin, const char* end, uint32_t threads)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    release();
+    if(threads <= 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    uint64_t size = static_cast<uint64_t>(end - begin);
+    if(threads <= 1 || size < ParallelThreshold || MaxSize < size) {
+        return parse(begin, end);
+    }
+    begin_ = begin;
+    end_ = end;
+    indexed_ = false;
+    projected_ = false;
+    const char* open = whitespace(begin);
+    const char* close = end - 1;
+    while(open < close && (0x20 == close[0] || 0x0A == close[0] || 0x0D == close[0] || 0x09 == close[0])) {
+        --close;
+    }
+    if(close <= open || !(('[' == open[0] && ']' == close[0]) || ('{' == open[0] && '}' == close[0]))) {
+        return parse(begin, end);
+    }
+
+    // Pieces are between the opening, the commas of the top level, and the closing
+    const char** splits = reinterpret_cast<const char**>(allocate(sizeof(const char*) * (threads + 1)));
+    if(CPPJSON_NULL == splits) {
+        return false;
+    }
+    splits[0] = open;
+    uint64_t pieces = split(open, threads, splits + 1) + 1;
+    splits[pieces] = close;
+    if(pieces <= 1) {
+        deallocate(splits);
+        return parse(begin, end);
+    }
+
+    /**
+     * @brief A piece parsed by a thread
+     */
+    struct Segment
+    {
+        JsonReader* reader_;
+        uint32_t count_;
+        uint32_t last_;
+        uint32_t base_;
+        uint32_t number_base_;
+        bool result_;
+    };
+    Segment* segments = reinterpret_cast<Segment*>(allocate(sizeof(Segment) * pieces));
+    std::thread* pool = reinterpret_cast<std::thread*>(allocate(sizeof(std::thread) * pieces));
+    bool result = CPPJSON_NULL != segments && CPPJSON_NULL != pool;
+    uint64_t created = 0;
+    for(; result && created < pieces; ++created) {
+        void* reader = allocate(sizeof(JsonReader));
+        if(CPPJSON_NULL == reader) {
+            result = false;
+            break;
+        }
+        segments[created].reader_ = new(reader) JsonReader(max_nesting_, allocator_);
+        segments[created].reader_->decoding_ = decoding_;
+        segments[created].reader_->stack_budget_ = stack_budget_;
+        segments[created].result_ = false;
+    }
+    if(result) {
+        bool object = '{' == open[0];
+        auto parse_piece = [&](uint64_t i) {
+            Segment& segment = segments[i];
+            segment.result_ = segment.reader_->parse_entries(begin, splits[i] + 1, splits[i + 1], object, segment.count_, segment.last_);
+        };
+        uint64_t started = 1;
+        while(started < pieces && start_thread(&pool[started], parse_piece, started)) {
+            ++started;
+        }
+        // Pieces whose threads cannot be started are parsed by the caller
+        parse_piece(0);
+        for(uint64_t i = started; i < pieces; ++i) {
+            parse_piece(i);
+        }
+        for(uint64_t i = 1; i < started; ++i) {
+            pool[i].join();
+            pool[i].~thread();
+        }
+    }
+
+    // Place the segments after the root
+    uint64_t total = 1;
+    uint64_t numbers = 0;
+    uint64_t count = 0;
+    for(uint64_t i = 0; result && i < pieces; ++i) {
+        result = segments[i].result_;
+        segments[i].base_ = static_cast<uint32_t>(total);
+        segments[i].number_base_ = static_cast<uint32_t>(numbers);
+        total += segments[i].reader_->size_;
+        numbers += segments[i].reader_->number_size_;
+        count += segments[i].count_;
+        result = result && total < Invalid;
+    }
+    nesting_ = 0;
+    size_ = 0;
+    number_size_ = 0;
+    table_size_ = 0;
+    if(result && capacity_ < total) {
+        result = expand(total);
+    }
+    if(result && number_capacity_ < numbers) {
+        JsonNumber* new_numbers = reinterpret_cast<JsonNumber*>(reallocate(numbers_, 0, sizeof(JsonNumber) * numbers));
+        result = CPPJSON_NULL != new_numbers;
+        if(result) {
+            numbers_ = new_numbers;
+            number_capacity_ = static_cast<uint32_t>(numbers);
+        }
+    }
+    if(result) {
+        values_[0].start_ = static_cast<JsonSize>(reinterpret_cast<uint64_t>(open) - reinterpret_cast<uint64_t>(begin));
+        values_[0].size_ = static_cast<JsonSize>(count);
+        values_[0].next_ = static_cast<uint32_t>(total);
+        values_[0].type_ = static_cast<uint32_t>('{' == open[0] ? JsonType::Object : JsonType::Array);
+        values_[0].flags_ = 0;
+        auto relocate_piece = [&](uint64_t i) {
+            relocate(*segments[i].reader_, segments[i].base_, segments[i].number_base_);
+            // Link the last entry to the first entry of the next segment
+            if((i + 1) < pieces) {
+                values_[segments[i].base_ + segments[i].last_].next_ = segments[i + 1].base_;
+            }
+        };
+        for(uint64_t i = 1; i < pieces; ++i) {
+            new(&pool[i]) std::thread(relocate_piece, i);
+        }
+        relocate_piece(0);
+        for(uint64_t i = 1; i < pieces; ++i) {
+            pool[i].join();
+            pool[i].~thread();
+        }
+        size_ = static_cast<uint32_t>(total);
+        number_size_ = static_cast<uint32_t>(numbers);
+    }
+
+    for(uint64_t i = 0; i < created; ++i) {
+        segments[i].reader_->~JsonReader();
+        deallocate(segments[i].reader_);
+    }
+    deallocate(pool);
+    deallocate(segments);
+    deallocate(splits);
+    begin_ = begin;
+    end_ = end;
+    return result;
+}
+
+uint64_t JsonReader::split(const char* open, uint64_t pieces, const char** splits) const
+{
+    // Track the depth of aggregations outside of strings, and take a comma of the top level after each target
+    uint64_t size = reinterpret_cast<uint64_t>(end_) - reinterpret_cast<uint64_t>(begin_);
+    uint64_t count = 0;
+    uint64_t target = size / pieces;
+    int64_t depth = 0;
+    uint64_t escaped = 0;
+    uint64_t in_string = 0;
+    for(uint64_t offset = 0; offset < size; offset += 64) {
+        const char* str = begin_ + offset;
+        char tail[64];
+        if((size - offset) < 64) {
+            ::memset(tail, 0x20, sizeof(tail));
+            ::memcpy(tail, str, size - offset);
+            str = tail;
+        }
+        JsonBlock block;
+        classify(block, str);
+        uint64_t quote;
+        uint64_t structurals = block.structural_ & ~find_strings(block, escaped, in_string, quote);
+        while(0 != structurals) {
+            uint64_t position = offset + count_trailing_zeros(structurals);
+            structurals &= structurals - 1;
+            switch(begin_[position]) {
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                --depth;
+                break;
+            case ',':
+                if(1 == depth && target <= position && open < (begin_ + position)) {
+                    splits[count] = begin_ + position;
+                    ++count;
+                    if(pieces <= (count + 1)) {
+                        return count;
+                    }
+                    target = size / pieces * (count + 1);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+bool JsonReader::parse_entries(const char* data, const char* begin, const char* end, bool object, uint32_t& count, uint32_t& last)
+{
+    // The entries are the children of the top level
+    begin_ = data;
+    end_ = end;
+    clear();
+    nesting_ = 1;
+    count = 0;
+    last = Invalid;
+    const char* str = begin;
+    for(;;) {
+        str = whitespace(str);
+        if(end_ <= str || (object && '"' != str[0])) {
+            return false;
+        }
+        auto [n, v] = object ? parse_member(str) : parse_array_value(str);
+        if(CPPJSON_NULL == n) {
+            return false;
+        }
+        ++count;
+        if(Invalid != last) {
+            values_[last].next_ = v;
+        }
+        last = v;
+        str = whitespace(n);
+        if(end_ <= str) {
+            return true;
+        }
+        if(',' != str[0]) {
+            return false;
+        }
+        ++str;
+    }
+}
+
+void JsonReader::relocate(const JsonReader& segment, uint32_t base, uint32_t number_base)
+{
+    JsonValue* values = values_ + base;
+    for(uint32_t i = 0; i < segment.size_; ++i) {
+        JsonValue value = segment.values_[i];
+        switch(static_cast<JsonType>(value.type_)) {
+        case JsonType::Object:
+        case JsonType::Array:
+            value.next_ += base;
+            break;
+        case JsonType::KeyValue:
+            value.start_ += base;
+            value.size_ += base;
+            value.next_ = Invalid != value.next_ ? value.next_ + base : Invalid;
+            break;
+        case JsonType::ArrayValue:
+            value.size_ += base;
+            value.next_ = Invalid != value.next_ ? value.next_ + base : Invalid;
+            break;
+        case JsonType::Number:
+        case JsonType::Integer:
+            if(0 != (value.flags_ & JsonValue::Decoded)) {
+                value.next_ += number_base;
+            }
+            break;
+        default:
+            break;
+        }
+        values[i] = value;
+    }
+    if(0 < segment.number_size_) {
+        ::memcpy(numbers_ + number_base, segment.numbers_, sizeof(JsonNumber) * segment.number_size_);
+    }
+}
+#endif // CPPJSON_NO_THREADS
+
+bool JsonReader::push_state(uint32_t node)
+{
+    if(state_capacity_ <= state_size_) {
+        uint32_t capacity = state_capacity_ + 64;
+        uint32_t* states = reinterpret_cast<uint32_t*>(reallocate(states_, sizeof(uint32_t) * state_size_, sizeof(uint32_t) * capacity));
+        if(CPPJSON_NULL == states) {
+            return false;
+        }
+        states_ = states;
+        state_capacity_ = capacity;
+    }
+    states_[state_size_] = node;
+    ++state_size_;
+    return true;
+}
+
+bool JsonReader::resolve(uint32_t value, uint32_t first, uint32_t count)
+{
+    // Record the paths which end at the value, then follow the remaining tokens in the parsed subtree
+    for(uint32_t i = first; i < (first + count); ++i) {
+        uint32_t path = query_->nodes_[states_[i]].path_;
+        if(JsonQuery::Invalid == path) {
+            continue;
+        }
+        if(match_capacity_ <= match_size_) {
+            uint32_t capacity = match_capacity_ + (match_capacity_ >> 1) + 16;
+            Match* matches = reinterpret_cast<Match*>(reallocate(matches_, sizeof(Match) * match_size_, sizeof(Match) * capacity));
+            if(CPPJSON_NULL == matches) {
+                return false;
+            }
+            matches_ = matches;
+            match_capacity_ = capacity;
+        }
+        matches_[match_size_] = {path, value};
+        ++match_size_;
+    }
+    bool object = static_cast<uint32_t>(JsonType::Object) == values_[value].type_;
+    if((!object && static_cast<uint32_t>(JsonType::Array) != values_[value].type_) || values_[value].size_ <= 0) {
+        return true;
+    }
+    uint32_t index = 0;
+    for(uint32_t entry = value + 1; Invalid != entry; entry = values_[entry].next_, ++index) {
+        uint32_t size = state_size_;
+        for(uint32_t i = first; i < (first + count); ++i) {
+            for(uint32_t child = query_->nodes_[states_[i]].child_; JsonQuery::Invalid != child; child = query_->nodes_[child].sibling_) {
+                const JsonQuery::Node& node = query_->nodes_[child];
+                bool matched = node.wildcard_ || (object ? equals(entry, query_->tokens_ + node.token_, node.token_size_) : index == node.index_);
+                if(matched && !push_state(child)) {
+                    return false;
+                }
+            }
+        }
+        bool result = size == state_size_ || resolve(static_cast<uint32_t>(values_[entry].size_), size, state_size_ - size);
+        state_size_ = size;
+        if(!result) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* JsonReader::parse_query_value(const char* str, uint32_t first, uint32_t count)
+{
+    // A value where any path ends is parsed, the others are walked without elements, and pruned ones are validated by skip_element
+    for(uint32_t i = first; i < (first + count); ++i) {
+        if(JsonQuery::Invalid != query_->nodes_[states_[i]].path_) {
+            auto [n, v] = parse_value(str);
+            if(CPPJSON_NULL == n || !resolve(v, first, count)) {
+                return CPPJSON_NULL;
+            }
+            return n;
+        }
+    }
+    if(end_ <= str) {
+        return CPPJSON_NULL;
+    }
+    if('{' != str[0] && '[' != str[0]) {
+        return skip_element(str);
+    }
+    bool object = '{' == str[0];
+    char close = object ? '}' : ']';
+    if(max_nesting_ <= nesting_) {
+        return CPPJSON_NULL;
+    }
+    ++nesting_;
+    str = skip_whitespace(str + 1, end_);
+    if(str < end_ && close == str[0]) {
+        --nesting_;
+        return str + 1;
+    }
+    for(uint32_t index = 0;; ++index) {
+        const char* key = str;
+        uint64_t key_size = 0;
+        if(object) {
+            if(end_ <= str || '"' != str[0]) {
+                return CPPJSON_NULL;
+            }
+            str = scan_string(str + 1);
+            if(CPPJSON_NULL == str) {
+                return CPPJSON_NULL;
+            }
+            key_size = static_cast<uint64_t>(str - key) - 1;
+            str = skip_whitespace(str + 1, end_);
+            if(end_ <= str || ':' != str[0]) {
+                return CPPJSON_NULL;
+            }
+            str = skip_whitespace(str + 1, end_);
+        }
+        if(end_ <= str) {
+            return CPPJSON_NULL;
+        }
+
+        // Gather the tokens which match this member or element
+        uint32_t size = state_size_;
+        for(uint32_t i = first; i < (first + count); ++i) {
+            for(uint32_t child = query_->nodes_[states_[i]].child_; JsonQuery::Invalid != child; child = query_->nodes_[child].sibling_) {
+                bool matched = object ? query_->matches(child, key + 1, key_size) : (query_->nodes_[child].wildcard_ || index == query_->nodes_[child].index_);
+                if(matched && !push_state(child)) {
+                    return CPPJSON_NULL;
+                }
+            }
+        }
+        str = size < state_size_ ? parse_query_value(str, size, state_size_ - size) : skip_element(str);
+        state_size_ = size;
+        if(CPPJSON_NULL == str) {
+            return CPPJSON_NULL;
+        }
+        str = skip_whitespace(str, end_);
+        if(end_ <= str) {
+            return CPPJSON_NULL;
+        }
+        if(close == str[0]) {
+            --nesting_;
+            return str + 1;
+        }
+        if(',' != str[0]) {
+            return CPPJSON_NULL;
+        }
+        str = skip_whitespace(str + 1, end_);
+    }
+}
+
+void JsonReader::beginStream()
+{
+    release();
+    stream_size_ = 0;
+    stream_offset_ = 0;
+    stream_scan_ = 0;
+    expect_ = Expect::Value;
+    frame_size_ = 0;
+    begin_ = stream_;
+    end_ = stream_;
+    nesting_ = 0;
+    size_ = 0;
+    number_size_ = 0;
+    table_size_ = 0;
+    indexed_ = false;
+    projected_ = false;
+}
+
+bool JsonReader::feed(const char* begin, const char* end)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    if(Expect::Error == expect_) {
+        return false;
+    }
+    uint64_t size = static_cast<uint64_t>(end - begin);
+    if((MaxSize - stream_size_) < size) {
+        expect_ = Expect::Error;
+        return false;
+    }
+    if(stream_capacity_ < (stream_size_ + size)) {
+        uint64_t capacity = stream_capacity_ * 2;
+        capacity = capacity < (stream_size_ + size) ? stream_size_ + size : capacity;
+        char* stream = reinterpret_cast<char*>(reallocate(stream_, stream_size_, capacity));
+        if(CPPJSON_NULL == stream) {
+            expect_ = Expect::Error;
+            return false;
+        }
+        stream_ = stream;
+        stream_capacity_ = capacity;
+    }
+    if(0 < size) {
+        ::memcpy(stream_ + stream_size_, begin, size);
+    }
+    stream_size_ += size;
+    begin_ = stream_;
+    end_ = stream_ + stream_size_;
+    if(!advance(false)) {
+        expect_ = Expect::Error;
+        return false;
+    }
+    return true;
+}
+
+bool JsonReader::finish()
+{
+    if(Expect::Error == expect_) {
+        return false;
+    }
+    if(!advance(true)) {
+        expect_ = Expect::Error;
+        return false;
+    }
+    return 0 == frame_size_ && Expect::End == expect_;
+}
+
+JsonProxy JsonReader::root() const
+{
+    if(size_ <= 0) {
+        return {Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
+    }
+    return {0, begin_, values_, numbers_, this};
+}
+
+JsonCursor JsonReader::cursor(const char* begin, const char* end)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    return make_cursor(skip_whitespace(begin, end), end);
+}
+
+void* JsonReader::allocate(size_t size) const
+{
+    return allocator_.allocate_(allocator_.context_, size);
+}
+
+void JsonReader::deallocate(void* ptr) const
+{
+    allocator_.deallocate_(allocator_.context_, ptr);
+}
+
+void* JsonReader::reallocate(void* ptr, size_t size, size_t new_size) const
+{
+    if(CPPJSON_NULL != allocator_.reallocate_) {
+        return allocator_.reallocate_(allocator_.context_, ptr, size, new_size);
+    }
+    void* result = allocate(new_size);
+    if(CPPJSON_NULL == result) {
+        return CPPJSON_NULL;
+    }
+    if(0 < size) {
+        ::memcpy(result, ptr, size);
+    }
+    deallocate(ptr);
+    return result;
+}
+
+bool JsonReader::expand(uint64_t capacity)
+{
+    // The last index is reserved for Invalid
+    if(Invalid < capacity || (SIZE_MAX / sizeof(JsonValue)) < capacity) {
+        return false;
+    }
+    JsonValue* values = reinterpret_cast<JsonValue*>(reallocate(values_, sizeof(JsonValue) * size_, sizeof(JsonValue) * capacity));
+    if(CPPJSON_NULL == values) {
+        return false;
+    }
+    capacity_ = static_cast<uint32_t>(capacity);
+    values_ = values;
+    return true;
+}
+
+uint32_t JsonReader::add()
+{
+    if(capacity_ <= size_) {
+        uint64_t growth = static_cast<uint64_t>(capacity_) * growth_ / 100;
+        uint64_t capacity = capacity_ + (expand_ < growth ? growth : expand_);
+        if(Invalid < capacity) {
+            capacity = Invalid;
+        }
+        if(capacity <= size_ || !expand(capacity)) {
+            return Invalid;
+        }
+    }
+    uint32_t current = size_;
+    values_[current].flags_ = 0;
+    ++size_;
+    return current;
+}
+
+void JsonReader::add_value(uint32_t set, uint32_t& last, uint32_t value)
+{
+    ++values_[set].size_;
+    if(Invalid != last) {
+        values_[last].next_ = value;
+    }
+    last = value;
+}
+
+bool JsonReader::decode(uint32_t value, JsonType type, const char* first, const char* last)
+{
+    if(number_capacity_ <= number_size_) {
+        uint64_t capacity = number_capacity_ + (number_capacity_ < Expand ? Expand : number_capacity_);
+        if(Invalid < capacity) {
+            capacity = Invalid;
+        }
+        if(capacity <= number_size_) {
+            return false;
+        }
+        JsonNumber* numbers = reinterpret_cast<JsonNumber*>(reallocate(numbers_, sizeof(JsonNumber) * number_size_, sizeof(JsonNumber) * capacity));
+        if(CPPJSON_NULL == numbers) {
+            return false;
+        }
+        numbers_ = numbers;
+        number_capacity_ = static_cast<uint32_t>(capacity);
+    }
+    JsonNumber& number = numbers_[number_size_];
+    uint32_t flags = JsonValue::Decoded;
+    if(JsonType::Integer == type) {
+        flags |= decode_integer(number, first, last);
+    } else {
+        number.float64_ = decode_float(first, last);
+    }
+    values_[value].next_ = number_size_;
+    values_[value].flags_ = flags;
+    ++number_size_;
+    return true;
+}
+
+bool JsonReader::equals(uint32_t entry, const char* key, uint64_t size) const
+{
+    const JsonValue& element = values_[values_[entry].start_];
+    return size == element.size_ && (0 == size || 0 == ::memcmp(begin_ + element.start_, key, size));
+}
+
+uint32_t JsonReader::table(uint64_t size) const
+{
+    uint64_t capacity = static_cast<uint64_t>(table_size_) + size;
+    if(Invalid < capacity) {
+        return Invalid;
+    }
+    if(table_capacity_ < capacity) {
+        uint64_t new_capacity = capacity < (table_capacity_ * 2ULL) ? table_capacity_ * 2ULL : capacity;
+        new_capacity = Invalid < new_capacity ? Invalid : new_capacity;
+        uint32_t* tables = reinterpret_cast<uint32_t*>(reallocate(tables_, sizeof(uint32_t) * table_size_, sizeof(uint32_t) * new_capacity));
+        if(CPPJSON_NULL == tables) {
+            return Invalid;
+        }
+        tables_ = tables;
+        table_capacity_ = static_cast<uint32_t>(new_capacity);
+    }
+    uint32_t position = table_size_;
+    table_size_ = static_cast<uint32_t>(capacity);
+    return position;
+}
+
+bool JsonReader::buildTables()
+{
+    for(uint32_t i = 0; i < size_; ++i) {
+        const JsonValue& value = values_[i];
+        if(IndexThreshold < value.size_ && 0 == (value.flags_ & JsonValue::Indexed)) {
+            if(static_cast<uint32_t>(JsonType::Object) == value.type_ && !hash(i)) {
+                return false;
+            }
+            if(static_cast<uint32_t>(JsonType::Array) == value.type_ && !tabulate(i)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool JsonReader::hash(uint32_t object) const
+{
+    // The size of table is a power of two, and at least twice of members
+    uint64_t members = values_[object].size_;
+    uint64_t size = 1;
+    while(size < members * 2) {
+        size <<= 1;
+    }
+    uint32_t position = table(size + 1);
+    if(Invalid == position) {
+        return false;
+    }
+    uint32_t mask = static_cast<uint32_t>(size - 1);
+    uint32_t* entries = tables_ + position + 1;
+    tables_[position] = mask;
+    for(uint32_t i = 0; i <= mask; ++i) {
+        entries[i] = Invalid;
+    }
+    // Entries are inserted in document order, so that the first one of duplicated keys is found first
+    for(uint32_t entry = object + 1; Invalid != entry; entry = values_[entry].next_) {
+        const JsonValue& key = values_[values_[entry].start_];
+        uint32_t i = hash_key(begin_ + key.start_, key.size_) & mask;
+        while(Invalid != entries[i]) {
+            i = (i + 1) & mask;
+        }
+        entries[i] = entry;
+    }
+    // The first key is a string, whose next_ is not used
+    values_[object + 2].next_ = position;
+    values_[object].flags_ |= JsonValue::Indexed;
+    return true;
+}
+
+bool JsonReader::tabulate(uint32_t array) const
+{
+    uint32_t position = table(values_[array].size_);
+    if(Invalid == position) {
+        return false;
+    }
+    uint32_t* entries = tables_ + position;
+    for(uint32_t entry = array + 1; Invalid != entry; entry = values_[entry].next_) {
+        *entries = static_cast<uint32_t>(values_[entry].size_);
+        ++entries;
+    }
+    // The start_ of an array's entry is not used
+    values_[array + 1].start_ = position;
+    values_[array].flags_ |= JsonValue::Indexed;
+    return true;
+}
+
+uint32_t JsonReader::at(uint32_t array, uint64_t index) const
+{
+    if(values_[array].size_ <= index) {
+        return Invalid;
+    }
+    if(IndexThreshold < values_[array].size_ && (0 != (values_[array].flags_ & JsonValue::Indexed) || tabulate(array))) {
+        return tables_[values_[array + 1].start_ + index];
+    }
+    uint32_t entry = array + 1;
+    for(; 0 < index; --index) {
+        entry = values_[entry].next_;
+    }
+    return static_cast<uint32_t>(values_[entry].size_);
+}
+
+uint32_t JsonReader::find(uint32_t object, const char* key, uint64_t size) const
+{
+    if(values_[object].size_ <= 0) {
+        return Invalid;
+    }
+    if(IndexThreshold < values_[object].size_ && (0 != (values_[object].flags_ & JsonValue::Indexed) || hash(object))) {
+        uint32_t position = values_[object + 2].next_;
+        uint32_t mask = tables_[position];
+        const uint32_t* entries = tables_ + position + 1;
+        for(uint32_t i = hash_key(key, size) & mask; Invalid != entries[i]; i = (i + 1) & mask) {
+            if(equals(entries[i], key, size)) {
+                return entries[i];
+            }
+        }
+        return Invalid;
+    }
+    for(uint32_t entry = object + 1; Invalid != entry; entry = values_[entry].next_) {
+        if(equals(entry, key, size)) {
+            return entry;
+        }
+    }
+    return Invalid;
+}
+
+bool JsonReader::index()
+{
+    uint64_t size = reinterpret_cast<uint64_t>(end_) - reinterpret_cast<uint64_t>(begin_);
+    if(Invalid <= size) {
+        return false;
+    }
+    structural_size_ = 0;
+    structural_ = 0;
+    uint64_t blocks = (size + 63) / 64;
+    if(special_capacity_ < blocks) {
+        deallocate(specials_);
+        specials_ = reinterpret_cast<uint64_t*>(allocate(sizeof(uint64_t) * blocks));
+        if(CPPJSON_NULL == specials_) {
+            special_capacity_ = 0;
+            return false;
+        }
+        special_capacity_ = blocks;
+    }
+    uint64_t escaped = 0; // whether the first byte of the next block is escaped
+    uint64_t in_string = 0; // whether the previous block ends inside of a string
+    uint64_t scalar = 0; // whether the previous block ends with a scalar
+    for(uint64_t offset = 0; offset < size; offset += 64) {
+        const char* str = begin_ + offset;
+        char tail[64];
+        if((size - offset) < 64) {
+            ::memset(tail, 0x20, sizeof(tail));
+            ::memcpy(tail, str, size - offset);
+            str = tail;
+        }
+        JsonBlock block;
+        classify(block, str);
+        uint64_t quote;
+        uint64_t string = find_strings(block, escaped, in_string, quote);
+
+        // Tokens other than structurals start after structurals, whitespaces or quotes
+        uint64_t scalars = ~(block.structural_ | block.whitespace_);
+        uint64_t nonquote_scalars = scalars & ~quote;
+        uint64_t follows_scalars = (nonquote_scalars << 1) | scalar;
+        scalar = nonquote_scalars >> 63;
+        uint64_t structurals = (block.structural_ | (scalars & ~follows_scalars) | quote) & ~(string & ~quote);
+        specials_[offset / 64] = block.special_ & string;
+
+        if(structural_capacity_ < (structural_size_ + 64)) {
+            uint64_t capacity = structural_capacity_ + (structural_capacity_ < 1024 ? 1024 : structural_capacity_);
+            if(Invalid < capacity) {
+                capacity = Invalid;
+            }
+            uint32_t* structurals = reinterpret_cast<uint32_t*>(reallocate(structurals_, sizeof(uint32_t) * structural_size_, sizeof(uint32_t) * capacity));
+            if(CPPJSON_NULL == structurals) {
+                return false;
+            }
+            structurals_ = structurals;
+            structural_capacity_ = static_cast<uint32_t>(capacity);
+        }
+        while(0 != structurals) {
+            structurals_[structural_size_] = static_cast<uint32_t>(offset + count_trailing_zeros(structurals));
+            ++structural_size_;
+            structurals &= structurals - 1;
+        }
+    }
+    return true;
+}
+
+bool JsonReader::is_plain(uint32_t begin, uint32_t end) const
+{
+    CPPJSON_ASSERT(begin <= end);
+    uint32_t first = begin / 64;
+    uint32_t last = end / 64;
+    uint64_t head = ~0ULL << (begin % 64);
+    if(first == last) {
+        return 0 == (specials_[first] & head & ~(~0ULL << (end % 64)));
+    }
+    if(0 != (specials_[first] & head)) {
+        return false;
+    }
+    for(uint32_t i = first + 1; i < last; ++i) {
+        if(0 != specials_[i]) {
+            return false;
+        }
+    }
+    return 0 == (end % 64) || 0 == (specials_[last] & ~(~0ULL << (end % 64)));
+}
+
+bool JsonReader::push(uint32_t aggregation, Expect expect)
+{
+    if(frame_capacity_ <= frame_size_) {
+        uint32_t capacity = frame_capacity_ < 16 ? 16 : frame_capacity_ * 2;
+        Frame* frames = reinterpret_cast<Frame*>(reallocate(frames_, sizeof(Frame) * frame_size_, sizeof(Frame) * capacity));
+        if(CPPJSON_NULL == frames) {
+            return false;
+        }
+        frames_ = frames;
+        frame_capacity_ = capacity;
+    }
+    frames_[frame_size_] = {aggregation, Invalid, expect};
+    ++frame_size_;
+    return true;
+}
+
+bool JsonReader::complete(const char* str, bool last)
+{
+    if(last) {
+        return true;
+    }
+    switch(str[0]) {
+    case '"': {
+        // Search the closing quote which is not escaped, from where the previous search stopped
+        uint64_t offset = reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_);
+        const char* next = begin_ + (offset < stream_scan_ ? stream_scan_ : offset + 1);
+        for(;;) {
+            const char* quote = reinterpret_cast<const char*>(::memchr(next, '"', end_ - next));
+            if(CPPJSON_NULL == quote) {
+                stream_scan_ = reinterpret_cast<uint64_t>(end_) - reinterpret_cast<uint64_t>(begin_);
+                return false;
+            }
+            uint64_t backslashes = 0;
+            for(const char* i = quote - 1; str < i && '\\' == i[0]; --i) {
+                ++backslashes;
+            }
+            if(0 == (backslashes & 1)) {
+                return true;
+            }
+            next = quote + 1;
+        }
+    }
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        // A number continues to the end of the chunk may continue to the next chunk
+        for(++str; str < end_; ++str) {
+            switch(str[0]) {
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+            case '.':
+            case 'e':
+            case 'E':
+            case '+':
+            case '-':
+                break;
+            default:
+                return true;
+            }
+        }
+        return false;
+    case 't':
+    case 'n':
+        return (str + 4) <= end_;
+    case 'f':
+        return (str + 5) <= end_;
+    default:
+        return true;
+    }
+}
+
+bool JsonReader::advance(bool last)
+{
+    const char* str = begin_ + stream_offset_;
+    for(;;) {
+        str = whitespace(str);
+        stream_offset_ = reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_);
+        if(end_ <= str) {
+            return true;
+        }
+        Frame* frame = 0 < frame_size_ ? &frames_[frame_size_ - 1] : CPPJSON_NULL;
+        Expect expect = CPPJSON_NULL != frame ? frame->expect_ : expect_;
+        bool object = CPPJSON_NULL != frame && static_cast<uint32_t>(JsonType::Object) == values_[frame->aggregation_].type_;
+        switch(expect) {
+        case Expect::Colon:
+            if(':' != str[0]) {
+                return false;
+            }
+            ++str;
+            frame->expect_ = Expect::Value;
+            continue;
+        case Expect::Comma:
+            if(',' == str[0]) {
+                ++str;
+                frame->expect_ = object ? Expect::Member : Expect::Value;
+                continue;
+            }
+            if((object ? '}' : ']') != str[0]) {
+                return false;
+            }
+            break;
+        case Expect::FirstMember:
+            if('}' == str[0]) {
+                break;
+            }
+            // fall through
+        case Expect::Member: {
+            if('"' != str[0]) {
+                return false;
+            }
+            if(!complete(str, last)) {
+                return true;
+            }
+            uint32_t keyvalue = add();
+            if(Invalid == keyvalue) {
+                return false;
+            }
+            values_[keyvalue].start_ = Invalid;
+            values_[keyvalue].size_ = Invalid;
+            values_[keyvalue].next_ = Invalid;
+            values_[keyvalue].type_ = static_cast<uint32_t>(JsonType::KeyValue);
+            add_value(frame->aggregation_, frame->last_, keyvalue);
+            auto [n, v] = parse_string(str);
+            if(CPPJSON_NULL == n) {
+                return false;
+            }
+            values_[keyvalue].start_ = v;
+            str = n;
+            frame->expect_ = Expect::Colon;
+        }
+            continue;
+        case Expect::FirstValue:
+            if(']' == str[0]) {
+                break;
+            }
+            // fall through
+        case Expect::Value: {
+            bool aggregation = '{' == str[0] || '[' == str[0];
+            if(!aggregation && !complete(str, last)) {
+                return true;
+            }
+            // The entry of an object is added with its key
+            uint32_t entry = CPPJSON_NULL != frame ? frame->last_ : Invalid;
+            if(CPPJSON_NULL != frame && !object) {
+                entry = add();
+                if(Invalid == entry) {
+                    return false;
+                }
+                values_[entry].start_ = Invalid;
+                values_[entry].size_ = Invalid;
+                values_[entry].next_ = Invalid;
+                values_[entry].type_ = static_cast<uint32_t>(JsonType::ArrayValue);
+                add_value(frame->aggregation_, frame->last_, entry);
+            }
+            if(CPPJSON_NULL != frame) {
+                frame->expect_ = Expect::Comma;
+            } else {
+                expect_ = Expect::End;
+            }
+            if(aggregation) {
+                // Open aggregations are on frames, limited by the same budget as parse, where the outermost one is not on frames
+                if(stack_budget_ < (sizeof(Frame) * static_cast<uint64_t>(frame_size_))) {
+                    return false;
+                }
+                uint32_t value = add();
+                if(Invalid == value) {
+                    return false;
+                }
+                values_[value].start_ = static_cast<JsonSize>(reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_));
+                values_[value].size_ = 0;
+                values_[value].next_ = Invalid;
+                values_[value].type_ = static_cast<uint32_t>('{' == str[0] ? JsonType::Object : JsonType::Array);
+                if(Invalid != entry) {
+                    values_[entry].size_ = value;
+                }
+                if(!push(value, '{' == str[0] ? Expect::FirstMember : Expect::FirstValue)) {
+                    return false;
+                }
+                ++str;
+                continue;
+            }
+            auto [n, v] = parse_value(str);
+            if(CPPJSON_NULL == n) {
+                return false;
+            }
+            if(Invalid != entry) {
+                values_[entry].size_ = v;
+            }
+            str = n;
+        }
+            continue;
+        default:
+            return false;
+        }
+        // Close the aggregation
+        values_[frame->aggregation_].next_ = size_;
+        --frame_size_;
+        ++str;
+    }
+}
+
+const char* JsonReader::whitespace(const char* str)
+{
+    if(indexed_) {
+        if(end_ <= str) {
+            return str;
+        }
+        switch(str[0]) {
+        case 0x20:
+        case 0x0A:
+        case 0x0D:
+        case 0x09:
+            break;
+        default:
+            return str;
+        }
+        // The next token is the next structural in the index, because all characters before it are whitespaces
+        uint32_t offset = static_cast<uint32_t>(reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_));
+        while(structural_ < structural_size_ && structurals_[structural_] < offset) {
+            ++structural_;
+        }
+        return structural_ < structural_size_ ? begin_ + structurals_[structural_] : end_;
+    }
+    while(str < end_) {
+        switch(str[0]) {
+        case 0x20:
+        case 0x0A:
+        case 0x0D:
+        case 0x09:
+            ++str;
+            break;
+        default:
+            return str;
+        }
+    }
+    return str;
+}
+
+const char* JsonReader::parse_utf8(const char* str)
+{
+    const uint8_t* u = reinterpret_cast<const uint8_t*>(str);
+
+    if(0x20U <= u[0] && u[0] < 0x80U) {
+        return str + 1;
+    }
+
+    if(0xC2U <= u[0] && u[0] <= 0xDFU) {
+        if(end_ <= (str + 1)) {
+            return CPPJSON_NULL;
+        }
+        if(!is_continuation(u[1])) {
+            return CPPJSON_NULL;
+        }
+        return str + 2;
+    }
+
+    if(0xE0U <= u[0] && u[0] < 0xF0U) {
+        if(end_ <= (str + 2)) {
+            return CPPJSON_NULL;
+        }
+        if(!is_continuation(u[1]) || !is_continuation(u[2])) {
+            return CPPJSON_NULL;
+        }
+        // overlong forms and surrogates
+        if(0xE0U == u[0] && u[1] < 0xA0U) {
+            return CPPJSON_NULL;
+        }
+        if(0xEDU == u[0] && 0xA0U <= u[1]) {
+            return CPPJSON_NULL;
+        }
+        return str + 3;
+    }
+
+    if(0xF0U <= u[0] && u[0] <= 0xF4U) {
+        if(end_ <= (str + 3)) {
+            return CPPJSON_NULL;
+        }
+        if(!is_continuation(u[1]) || !is_continuation(u[2]) || !is_continuation(u[3])) {
+            return CPPJSON_NULL;
+        }
+        // overlong forms and larger than U+10FFFF
+        if(0xF0U == u[0] && u[1] < 0x90U) {
+            return CPPJSON_NULL;
+        }
+        if(0xF4U == u[0] && 0x90U <= u[1]) {
+            return CPPJSON_NULL;
+        }
+        return str + 4;
+    }
+    return CPPJSON_NULL;
+}
+
+const char* JsonReader::skip_plain(const char* str)
+{
+#if defined(CPPJSON_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+#    if defined(CPPJSON_SSSE3)
+    // Skip bytes until a quote, a backslash or a control character, validating UTF-8 sequences
+    __m128i prev = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    for(;;) {
+        __m128i input;
+        if((str + 16) <= end_) {
+            input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+        } else {
+            char tail[16];
+            ::memset(tail, '"', sizeof(tail));
+            ::memcpy(tail, str, end_ - str);
+            input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail));
+        }
+        __m128i stops = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(input, quote), _mm_cmpeq_epi8(input, backslash)), _mm_cmpeq_epi8(_mm_min_epu8(input, control), input));
+        uint32_t stop = static_cast<uint32_t>(_mm_movemask_epi8(stops));
+        if(0 == stop) {
+            if(0 != _mm_movemask_epi8(_mm_or_si128(input, prev))) {
+                error = _mm_or_si128(error, check_utf8(input, prev));
+            }
+            prev = input;
+            str += 16;
+            continue;
+        }
+        // Clear the stop and after it, then a sequence cut by the stop becomes an error
+        uint32_t count = count_trailing_zeros(stop);
+        const __m128i indices = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        input = _mm_and_si128(input, _mm_cmplt_epi8(indices, _mm_set1_epi8(static_cast<char>(count))));
+        if(0 != _mm_movemask_epi8(_mm_or_si128(input, prev))) {
+            error = _mm_or_si128(error, check_utf8(input, prev));
+        }
+        if(0xFFFFU != static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())))) {
+            return CPPJSON_NULL;
+        }
+        str += count;
+        return str < end_ ? str : end_;
+    }
+#    else
+    // Skip ascii bytes until a quote, a backslash, a control character or a non-ascii character
+    while((str + 16) <= end_) {
+        __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+        __m128i stops = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(input, quote), _mm_cmpeq_epi8(input, backslash)), _mm_cmpeq_epi8(_mm_min_epu8(input, control), input));
+        uint32_t stop = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(stops, input)));
+        if(0 != stop) {
+            return str + count_trailing_zeros(stop);
+        }
+        str += 16;
+    }
+    return str;
+#    endif
+#else
+    return str;
+#endif
+}
+
+const char* JsonReader::parse_element(const char* str)
+{
+    str = whitespace(str);
+    if(end_ <= str) {
+        return CPPJSON_NULL;
+    }
+    auto [n, v] = parse_value(str);
+    str = n;
+    if(CPPJSON_NULL == str) {
+        return CPPJSON_NULL;
+    }
+    return whitespace(str);
+}
+
+std::tuple<const char*, uint32_t> JsonReader::parse_value(const char* str)
+{
+    const char* begin = str;
+    const char* next = CPPJSON_NULL;
+    JsonType type;
+    switch(str[0]) {
+    case '"':
+        return parse_string(str);
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        next = scan_number(type, str);
+        break;
+    case '{':
+        return projecting_ ? parse_object(str) : parse_nested(str);
+    case '[':
+        return projecting_ ? parse_array(str) : parse_nested(str);
+    case 't':
+        type = JsonType::True;
+        next = parse_true(str);
+        break;
+    case 'f':
+        type = JsonType::False;
+        next = parse_false(str);
+        break;
+    case 'n':
+        type = JsonType::Null;
+        next = parse_null(str);
+        break;
+    default:
+        return InvalidPair;
+    }
+    if(CPPJSON_NULL == next) {
+        return InvalidPair;
+    }
+
+    uint32_t value = add();
+    if(Invalid == value) {
+        return InvalidPair;
+    }
+    values_[value].start_ = static_cast<JsonSize>(reinterpret_cast<uint64_t>(begin) - reinterpret_cast<uint64_t>(begin_));
+    values_[value].size_ = static_cast<JsonSize>(reinterpret_cast<uint64_t>(next) - reinterpret_cast<uint64_t>(begin));
+    values_[value].next_ = Invalid;
+    values_[value].type_ = static_cast<uint32_t>(type);
+    if(decoding_ && (JsonType::Integer == type || JsonType::Number == type) && !decode(value, type, begin, next)) {
+        return InvalidPair;
+    }
+    return {next, value};
+}
+
+std::tuple<const char*, uint32_t> JsonReader::parse_nested(const char* str)
+{
+    // The enclosing aggregations are pushed on frames, and the current one is kept in locals
+    CPPJSON_ASSERT('{' == str[0] || '[' == str[0]);
+    uint32_t base = frame_size_;
+    uint32_t root = size_;
+    uint32_t aggregation = Invalid;
+    uint32_t last = Invalid;
+    bool object = false;
+    for(;;) {
+        // A value at str
+        if(end_ <= str) {
+            return InvalidPair;
+        }
+        uint32_t entry = last;
+        if(Invalid != aggregation && !object) {
+            entry = add();
+            if(Invalid == entry) {
+                return InvalidPair;
+            }
+            values_[entry].start_ = Invalid;
+            values_[entry].size_ = Invalid;
+            values_[entry].next_ = Invalid;
+            values_[entry].type_ = static_cast<uint32_t>(JsonType::ArrayValue);
+            add_value(aggregation, last, entry);
+        }
+        if('{' == str[0] || '[' == str[0]) {
+            if(Invalid != aggregation) {
+                if(stack_budget_ < (sizeof(Frame) * (static_cast<uint64_t>(frame_size_ - base) + 1)) || !push(aggregation, Expect::Comma)) {
+                    return InvalidPair;
+                }
+                frames_[frame_size_ - 1].last_ = last;
+            }
+            object = '{' == str[0];
+            aggregation = add();
+            if(Invalid == aggregation) {
+                return InvalidPair;
+            }
+            values_[aggregation].start_ = static_cast<JsonSize>(reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_));
+            values_[aggregation].size_ = 0;
+            values_[aggregation].next_ = Invalid;
+            values_[aggregation].type_ = static_cast<uint32_t>(object ? JsonType::Object : JsonType::Array);
+            if(Invalid != entry) {
+                values_[entry].size_ = aggregation;
+            }
+            last = Invalid;
+            str = whitespace(str + 1);
+            if(end_ <= str) {
+                return InvalidPair;
+            }
+            if((object ? '}' : ']') != str[0]) {
+                str = object ? parse_key(str, aggregation, last) : str;
+                if(CPPJSON_NULL == str) {
+                    return InvalidPair;
+                }
+                continue;
+            }
+        } else {
+            auto [n, v] = parse_value(str);
+            if(CPPJSON_NULL == n) {
+                return InvalidPair;
+            }
+            if(Invalid != entry) {
+                values_[entry].size_ = v;
+            }
+            str = whitespace(n);
+        }
+
+        // Close aggregations until the next member or element
+        for(;;) {
+            if(end_ <= str) {
+                return InvalidPair;
+            }
+            if(',' == str[0]) {
+                str = whitespace(str + 1);
+                str = object ? parse_key(str, aggregation, last) : str;
+                if(CPPJSON_NULL == str) {
+                    return InvalidPair;
+                }
+                break;
+            }
+            if((object ? '}' : ']') != str[0]) {
+                return InvalidPair;
+            }
+            values_[aggregation].next_ = size_;
+            if(frame_size_ <= base) {
+                return {str + 1, root};
+            }
+            --frame_size_;
+            aggregation = frames_[frame_size_].aggregation_;
+            last = frames_[frame_size_].last_;
+            object = static_cast<uint32_t>(JsonType::Object) == values_[aggregation].type_;
+            str = whitespace(str + 1);
+        }
+    }
+}
+
+const char* JsonReader::parse_key(const char* str, uint32_t object, uint32_t& last)
+{
+    // The entry is added with its key, and the value follows
+    if(end_ <= str || '"' != str[0]) {
+        return CPPJSON_NULL;
+    }
+    uint32_t keyvalue = add();
+    if(Invalid == keyvalue) {
+        return CPPJSON_NULL;
+    }
+    values_[keyvalue].start_ = Invalid;
+    values_[keyvalue].size_ = Invalid;
+    values_[keyvalue].next_ = Invalid;
+    values_[keyvalue].type_ = static_cast<uint32_t>(JsonType::KeyValue);
+    add_value(object, last, keyvalue);
+    auto [n, v] = parse_string(str);
+    if(CPPJSON_NULL == n) {
+        return CPPJSON_NULL;
+    }
+    values_[keyvalue].start_ = v;
+    str = whitespace(n);
+    if(end_ <= str || ':' != str[0]) {
+        return CPPJSON_NULL;
+    }
+    return whitespace(str + 1);
+}
+
+std::tuple<const char*, uint32_t> JsonReader::parse_string(const char* str)
+{
+    CPPJSON_ASSERT('"' == str[0]);
+    ++str;
+    const char* begin = str;
+    uint32_t value = add();
+    if(Invalid == value) {
+        return InvalidPair;
+    }
+    values_[value].start_ = static_cast<JsonSize>(reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_));
+    values_[value].next_ = Invalid;
+    values_[value].type_ = static_cast<uint32_t>(JsonType::String);
+    if(indexed_) {
+        // The closing quote follows the opening quote in the index.
+        // The string is valid without examining, if it does not have any special characters.
+        uint32_t offset = static_cast<uint32_t>(reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_));
+        while(structural_ < structural_size_ && structurals_[structural_] < offset) {
+            ++structural_;
+        }
+        if(structural_size_ <= structural_) {
+            return InvalidPair;
+        }
+        uint32_t close = structurals_[structural_];
+        if('"' == begin_[close] && is_plain(offset, close)) {
+            values_[value].size_ = close - offset;
+            return {begin_ + close + 1, value};
+        }
+    }
+    bool escaped;
+    str = scan_string(str, escaped);
+    if(CPPJSON_NULL == str) {
+        return InvalidPair;
+    }
+    values_[value].size_ = static_cast<JsonSize>(reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin));
+    values_[value].flags_ = escaped ? JsonValue::Escaped : 0;
+    return {str + 1, value};
+}
+
+const char* JsonReader::scan_string(const char* str)
+{
+    bool escaped;
+    return scan_string(str, escaped);
+}
+
+const char* JsonReader::scan_string(const char* str, bool& escaped)
+{
+    // Validate the contents of a string, and return the closing quote
+    escaped = false;
+    while(str < end_) {
+        str = skip_plain(str);
+        if(CPPJSON_NULL == str || end_ <= str) {
+            return CPPJSON_NULL;
+        }
+        switch(str[0]) {
+        case '"':
+            return str;
+        case '\\': {
+            const char* next = str + 1;
+            if(end_ <= next) {
+                return CPPJSON_NULL;
+            }
+            escaped = true;
+            switch(next[0]) {
+            case '"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                str = next + 1;
+                break;
+            case 'u':
+                str = parse_4hex(next + 1);
+                if(CPPJSON_NULL == str) {
+                    return CPPJSON_NULL;
+                }
+                ++str;
+                break;
+            default:
+                return CPPJSON_NULL;
+            }
+        } break;
+        default:
+            str = parse_utf8(str);
+            if(CPPJSON_NULL == str) {
+                return CPPJSON_NULL;
+            }
+            break;
+        }
+    }
+    return CPPJSON_NULL;
+}
+
+const char* JsonReader::parse_4hex(const char* str)
+{
+    uint32_t count = 0;
+    while(str < end_) {
+        switch(str[0]) {
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+        case 'A':
+        case 'B':
+        case 'C':
+        case 'D':
+        case 'E':
+        case 'F':
+        case 'a':
+        case 'b':
+        case 'c':
+        case 'd':
+        case 'e':
+        case 'f':
+            ++count;
+            break;
+        default:
+            return CPPJSON_NULL;
+        }
+        if(4 <= count) {
+            return str;
+        }
+        ++str;
+    }
+    return CPPJSON_NULL;
+}
+
+const char* JsonReader::scan_number(JsonType& type, const char* str)
+{
+    if('-' == str[0]) {
+        ++str;
+        if(end_ <= str) {
+            return CPPJSON_NULL;
+        }
+    }
+    if('0' == str[0]) {
+        return parse_zero_number(type, str);
+    }
+    if('1' <= str[0] && str[0] <= '9') {
+        return parse_number(type, str);
+    }
+    return CPPJSON_NULL;
+}
+
+const char* JsonReader::parse_zero_number(JsonType& type, const char* str)
+{
+    CPPJSON_ASSERT('0' == str[0]);
+    ++str;
+    if(end_ <= str) {
+        type = JsonType::Integer;
+        return str;
+    }
+    switch(str[0]) {
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        return CPPJSON_NULL;
+    case '.':
+        type = JsonType::Number;
+        return parse_fraction(str);
+    case 'e':
+    case 'E':
+        type = JsonType::Number;
+        return parse_exponent(str);
+    default:
+        type = JsonType::Integer;
+        return str;
+    }
+}
+
+const char* JsonReader::parse_number(JsonType& type, const char* str)
+{
+    CPPJSON_ASSERT('1' <= str[0] && str[0] <= '9');
+    ++str;
+    while(str < end_) {
+        switch(str[0]) {
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            ++str;
+            break;
+        case '.':
+            type = JsonType::Number;
+            return parse_fraction(str);
+        case 'e':
+        case 'E':
+            type = JsonType::Number;
+            return parse_exponent(str);
+        default:
+            type = JsonType::Integer;
+            return str;
+        }
+    }
+    type = JsonType::Integer;
+    return str;
+}
+
+const char* JsonReader::parse_fraction(const char* str)
+{
+    CPPJSON_ASSERT('.' == str[0]);
+    str = parse_digits(str + 1);
+    if(CPPJSON_NULL == str || end_ <= str) {
+        return str;
+    }
+    switch(str[0]) {
+    case 'e':
+    case 'E':
+        return parse_exponent(str);
+    default:
+        return str;
+    }
+}
+
+const char* JsonReader::parse_exponent(const char* str)
+{
+    CPPJSON_ASSERT('e' == str[0] || 'E' == str[0]);
+    ++str;
+    if(end_ <= str) {
+        return CPPJSON_NULL;
+    }
+    if(str[0] == '-' || str[0] == '+') {
+        ++str;
+        if(end_ <= str) {
+            return CPPJSON_NULL;
+        }
+    }
+    return parse_digits(str);
+}
+
+const char* JsonReader::parse_digits(const char* str)
+{
+    uint32_t count = 0;
+    while(str < end_) {
+        switch(str[0]) {
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            ++str;
+            ++count;
+            break;
+        default:
+            return (0 < count) ? str : CPPJSON_NULL;
+        }
+    }
+    return (0 < count) ? str : CPPJSON_NULL;
+}
+
+std::tuple<const char*, uint32_t> JsonReader::parse_object(const char* str)
+{
+    CPPJSON_ASSERT('{' == str[0]);
+    if(max_nesting_ < ++nesting_) {
+        return InvalidPair;
+    }
+    uint32_t object = add();
+    if(Invalid == object) {
+        return InvalidPair;
+    }
+    values_[object].start_ = static_cast<JsonSize>(reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_));
+    values_[object].size_ = 0;
+    values_[object].next_ = Invalid;
+    values_[object].type_ = static_cast<uint32_t>(JsonType::Object);
+
+    ++str;
+    uint32_t last = Invalid;
+    bool needs_member = false;
+    bool needs_comma = false;
+    while(str < end_) {
+        str = whitespace(str);
+        if(end_ <= str) {
+            return InvalidPair;
+        }
+        switch(str[0]) {
+        case '}':
+            --nesting_;
+            if(!needs_member) {
+                values_[object].next_ = size_;
+                return {str + 1, object};
+            } else {
+                return InvalidPair;
+            }
+        case '"': {
+            if(needs_comma) {
+                return InvalidPair;
+            }
+            auto [n, v] = projecting_ ? project(str, true, 0) : parse_member(str);
+            str = n;
+            if(CPPJSON_NULL == str) {
+                return InvalidPair;
+            }
+            if(Invalid != v) {
+                add_value(object, last, v);
+            }
+            needs_member = false;
+            needs_comma = true;
+        } break;
+        case ',':
+            if(!needs_comma) {
+                return InvalidPair;
+            }
+            ++str;
+            needs_member = true;
+            needs_comma = false;
+            break;
+        default:
+            return InvalidPair;
+        }
+    }
+    return InvalidPair;
+}
+
+std::tuple<const char*, uint32_t> JsonReader::parse_member(const char* str)
+{
+    uint32_t keyvalue = add();
+    if(Invalid == keyvalue) {
+        return InvalidPair;
+    }
+    values_[keyvalue].start_ = Invalid;
+    values_[keyvalue].size_ = Invalid;
+    values_[keyvalue].next_ = Invalid;
+    values_[keyvalue].type_ = static_cast<uint32_t>(JsonType::KeyValue);
+
+    auto [n0, v0] = parse_string(str);
+    str = n0;
+    if(CPPJSON_NULL == str) {
+        return InvalidPair;
+    }
+    values_[keyvalue].start_ = v0;
+    str = whitespace(str);
+    if(end_ <= str || ':' != str[0]) {
+        return InvalidPair;
+    }
+    str = whitespace(str + 1);
+    if(end_ <= str) {
+        return InvalidPair;
+    }
+    auto [n1, v1] = parse_value(str);
+    values_[keyvalue].size_ = v1;
+    return {n1, keyvalue};
+}
+
+std::tuple<const char*, uint32_t> JsonReader::parse_array(const char* str)
+{
+    CPPJSON_ASSERT('[' == str[0]);
+    if(max_nesting_ < ++nesting_) {
+        return InvalidPair;
+    }
+    uint32_t object = add();
+    if(Invalid == object) {
+        return InvalidPair;
+    }
+    values_[object].start_ = static_cast<JsonSize>(reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_));
+    values_[object].size_ = 0;
+    values_[object].next_ = Invalid;
+    values_[object].type_ = static_cast<uint32_t>(JsonType::Array);
+    ++str;
+    uint32_t last = Invalid;
+    uint32_t index = 0;
+    bool needs_value = false;
+    bool needs_comma = false;
+    while(str < end_) {
+        str = whitespace(str);
+        if(end_ <= str) {
+            return InvalidPair;
+        }
+        switch(str[0]) {
+        case ']':
+            --nesting_;
+            if(!needs_value) {
+                values_[object].next_ = size_;
+                return {str + 1, object};
+            } else {
+                return InvalidPair;
+            }
+        case ',':
+            if(!needs_comma) {
+                return InvalidPair;
+            }
+            ++str;
+            needs_value = true;
+            needs_comma = false;
+            break;
+        default:
+            if(needs_comma) {
+                return InvalidPair;
+            }
+            auto [n, v] = projecting_ ? project(str, false, index) : parse_array_value(str);
+            str = n;
+            if(CPPJSON_NULL == str) {
+                return InvalidPair;
+            }
+            if(Invalid != v) {
+                add_value(object, last, v);
+            }
+            ++index;
+            needs_value = false;
+            needs_comma = true;
+            break;
+        }
+    }
+    return InvalidPair;
+}
+
+std::tuple<const char*, uint32_t> JsonReader::parse_array_value(const char* str)
+{
+    uint32_t arrayvalue = add();
+    if(Invalid == arrayvalue) {
+        return InvalidPair;
+    }
+    values_[arrayvalue].start_ = Invalid;
+    values_[arrayvalue].size_ = Invalid;
+    values_[arrayvalue].next_ = Invalid;
+    values_[arrayvalue].type_ = static_cast<uint32_t>(JsonType::ArrayValue);
+
+    auto [n0, v0] = parse_value(str);
+    str = n0;
+    if(CPPJSON_NULL == str) {
+        return InvalidPair;
+    }
+    values_[arrayvalue].size_ = v0;
+    return {n0, arrayvalue};
+}
+
+const char* JsonReader::parse_true(const char* str)
+{
+    CPPJSON_ASSERT('t' == str[0]);
+    if(end_ <= (str + 3)) {
+        return CPPJSON_NULL;
+    }
+    if('r' == str[1] && 'u' == str[2] && 'e' == str[3]) {
+        return str + 4;
+    }
+    return CPPJSON_NULL;
+}
+
+const char* JsonReader::parse_false(const char* str)
+{
+    CPPJSON_ASSERT('f' == str[0]);
+    if(end_ <= (str + 4)) {
+        return CPPJSON_NULL;
+    }
+    if('a' == str[1] && 'l' == str[2] && 's' == str[3] && 'e' == str[4]) {
+        return str + 5;
+    }
+    return CPPJSON_NULL;
+}
+
+const char* JsonReader::parse_null(const char* str)
+{
+    CPPJSON_ASSERT('n' == str[0]);
+    if(end_ <= (str + 3)) {
+        return CPPJSON_NULL;
+    }
+    if('u' == str[1] && 'l' == str[2] && 'l' == str[3]) {
+        return str + 4;
+    }
+    return CPPJSON_NULL;
+}
+
+std::tuple<const char*, uint32_t> JsonReader::project(const char* str, bool member, uint32_t index)
+{
+    // Gather the states which match the member or element, before adding any element
+    uint32_t structural = structural_;
+    const char* value = str;
+    const char* key = CPPJSON_NULL;
+    uint64_t key_size = 0;
+    if(member) {
+        key = str + 1;
+        const char* close = scan_string(key);
+        if(CPPJSON_NULL == close) {
+            return InvalidPair;
+        }
+        key_size = static_cast<uint64_t>(close - key);
+        value = whitespace(close + 1);
+        if(end_ <= value || ':' != value[0]) {
+            return InvalidPair;
+        }
+        value = whitespace(value + 1);
+    }
+    uint32_t first = state_first_;
+    uint32_t count = state_count_;
+    uint32_t size = state_size_;
+    bool whole = false;
+    for(uint32_t i = first; i < (first + count); ++i) {
+        for(uint32_t child = projection_->nodes_[states_[i]].child_; JsonQuery::Invalid != child; child = projection_->nodes_[child].sibling_) {
+            const JsonQuery::Node& node = projection_->nodes_[child];
+            bool matched = member ? projection_->matches(child, key, key_size) : (node.wildcard_ || index == node.index_);
+            if(!matched) {
+                continue;
+            }
+            if(!push_state(child)) {
+                return InvalidPair;
+            }
+            whole = whole || JsonQuery::Invalid != node.path_;
+        }
+    }
+    if(size == state_size_) {
+        return {skip_element(value), Invalid};
+    }
+
+    // The whole value is stored where a path ends, otherwise the projection continues
+    uint32_t rollback = size_;
+    uint32_t number_rollback = number_size_;
+    structural_ = structural;
+    projecting_ = !whole;
+    state_first_ = size;
+    state_count_ = state_size_ - size;
+    auto [n, v] = member ? parse_member(str) : parse_array_value(str);
+    projecting_ = true;
+    state_first_ = first;
+    state_count_ = count;
+    state_size_ = size;
+    if(CPPJSON_NULL == n) {
+        return InvalidPair;
+    }
+    uint32_t type = values_[values_[v].size_].type_;
+    if(!whole && static_cast<uint32_t>(JsonType::Object) != type && static_cast<uint32_t>(JsonType::Array) != type) {
+        // Drop a scalar, because paths go further
+        size_ = rollback;
+        number_size_ = number_rollback;
+        return {n, Invalid};
+    }
+    return {n, v};
+}
+
+const char* JsonReader::skip_element(const char* str)
+{
+    // Validate a value without adding elements, open aggregations are pushed on frames with what they expect
+    uint32_t base = frame_size_;
+    for(;;) {
+        if(CPPJSON_NULL == str || end_ <= str) {
+            return CPPJSON_NULL;
+        }
+        JsonType type;
+        switch(str[0]) {
+        case '"':
+            str = scan_string(str + 1);
+            str = CPPJSON_NULL != str ? str + 1 : CPPJSON_NULL;
+            break;
+        case '{':
+        case '[': {
+            bool object = '{' == str[0];
+            if(stack_budget_ < (sizeof(Frame) * (static_cast<uint64_t>(frame_size_ - base) + 1)) || !push(Invalid, object ? Expect::Member : Expect::Value)) {
+                return CPPJSON_NULL;
+            }
+            str = whitespace(str + 1);
+            if(str < end_ && (object ? '}' : ']') == str[0]) {
+                --frame_size_;
+                ++str;
+                break;
+            }
+            str = object ? skip_key(str) : str;
+            continue;
+        }
+        case 't':
+            str = parse_true(str);
+            break;
+        case 'f':
+            str = parse_false(str);
+            break;
+        case 'n':
+            str = parse_null(str);
+            break;
+        default:
+            str = scan_number(type, str);
+            break;
+        }
+
+        // Close aggregations until the next member or element
+        for(;;) {
+            if(CPPJSON_NULL == str) {
+                return CPPJSON_NULL;
+            }
+            if(frame_size_ <= base) {
+                return str;
+            }
+            str = whitespace(str);
+            if(end_ <= str) {
+                return CPPJSON_NULL;
+            }
+            bool object = Expect::Member == frames_[frame_size_ - 1].expect_;
+            if(',' == str[0]) {
+                str = whitespace(str + 1);
+                str = object ? skip_key(str) : str;
+                break;
+            }
+            if((object ? '}' : ']') != str[0]) {
+                return CPPJSON_NULL;
+            }
+            --frame_size_;
+            ++str;
+        }
+    }
+}
+
+const char* JsonReader::skip_key(const char* str)
+{
+    if(end_ <= str || '"' != str[0]) {
+        return CPPJSON_NULL;
+    }
+    str = scan_string(str + 1);
+    if(CPPJSON_NULL == str) {
+        return CPPJSON_NULL;
+    }
+    str = whitespace(str + 1);
+    if(end_ <= str || ':' != str[0]) {
+        return CPPJSON_NULL;
+    }
+    return whitespace(str + 1);
+}
+
+const char* JsonReader::event_begin(const char* begin, const char* end)
+{
+    // Events store no elements, so the previous result is discarded
+    release();
+    begin_ = begin;
+    end_ = end;
+    clear();
+    projected_ = false;
+    error_ = JsonError::None;
+    error_at_ = begin_;
+    if(MaxSize < static_cast<uint64_t>(end - begin)) {
+        return fail(begin_, JsonError::TooLarge);
+    }
+    indexed_ = indexing_ && index();
+    return whitespace(begin_);
+}
+
+bool JsonReader::event_push(const char* str, bool object)
+{
+    if(stack_budget_ < (sizeof(Frame) * (static_cast<uint64_t>(frame_size_) + 1))) {
+        fail(str, JsonError::TooDeep);
+        return false;
+    }
+    if(!push(0, object ? Expect::Member : Expect::Value)) {
+        fail(str, JsonError::NoMemory);
+        return false;
+    }
+    return true;
+}
+
+const char* JsonReader::event_key(const char* str, std::string_view& key)
+{
+    if(end_ <= str) {
+        return fail(str, JsonError::UnexpectedEnd);
+    }
+    if('"' != str[0]) {
+        return fail(str, JsonError::UnexpectedCharacter);
+    }
+    const char* close = event_string(str + 1);
+    if(CPPJSON_NULL == close) {
+        return CPPJSON_NULL;
+    }
+    key = std::string_view(str + 1, static_cast<size_t>(close - str - 1));
+    str = whitespace(close + 1);
+    if(end_ <= str) {
+        return fail(str, JsonError::UnexpectedEnd);
+    }
+    if(':' != str[0]) {
+        return fail(str, JsonError::UnexpectedCharacter);
+    }
+    return whitespace(str + 1);
+}
+
+const char* JsonReader::event_string(const char* str)
+{
+    // Strings are checked by the vectorized scan, and only an invalid one is walked again to find the error
+    const char* close = scan_string(str);
+    if(CPPJSON_NULL != close) {
+        return close;
+    }
+    while(str < end_) {
+        const uint8_t c = static_cast<uint8_t>(str[0]);
+        if('"' == c) {
+            return str;
+        }
+        if(c < 0x20U) {
+            return fail(str, JsonError::InvalidString);
+        }
+        if('\\' != c) {
+            const char* next = c < 0x80U ? str + 1 : parse_utf8(str);
+            if(CPPJSON_NULL == next) {
+                return fail(str, JsonError::InvalidUtf8);
+            }
+            str = next;
+            continue;
+        }
+        if(end_ <= (str + 1)) {
+            break;
+        }
+        switch(str[1]) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            str += 2;
+            break;
+        case 'u': {
+            const char* last = parse_4hex(str + 2);
+            if(CPPJSON_NULL == last) {
+                return fail(str, JsonError::InvalidEscape);
+            }
+            str = last + 1;
+        } break;
+        default:
+            return fail(str, JsonError::InvalidEscape);
+        }
+    }
+    return fail(end_, JsonError::UnexpectedEnd);
+}
+
+const char* JsonReader::event_number(const char* str, bool decoding, JsonType& type, uint32_t& flags, JsonNumber& number)
+{
+    const char* next = scan_number(type, str);
+    if(CPPJSON_NULL == next) {
+        return fail(str, JsonError::InvalidNumber);
+    }
+    flags = 0;
+    number.int64_ = 0;
+    if(!decoding) {
+        return next;
+    }
+    if(JsonType::Integer == type) {
+        flags = decode_integer(number, str, next);
+    } else {
+        number.float64_ = decode_float(str, next);
+    }
+    return next;
+}
+
+const char* JsonReader::fail(const char* str, JsonError error)
+{
+    error_ = error;
+    error_at_ = str < end_ ? str : end_;
+    return CPPJSON_NULL;
+}
+
+#ifndef CPPJSON_NO_BIND
+const char* JsonReader::bind_begin(const char* begin, const char* end)
+{
+    // Binding stores no elements, so the previous result is discarded
+    release();
+    begin_ = begin;
+    end_ = end;
+    nesting_ = 0;
+    frame_size_ = 0;
+    size_ = 0;
+    number_size_ = 0;
+    table_size_ = 0;
+    match_size_ = 0;
+    indexed_ = false;
+    projected_ = false;
+    if(MaxSize < static_cast<uint64_t>(end - begin)) {
+        return CPPJSON_NULL;
+    }
+    const char* str = whitespace(begin);
+    return str < end_ ? str : CPPJSON_NULL;
+}
+
+bool JsonReader::bind_end(const char* str)
+{
+    return CPPJSON_NULL != str && end_ <= whitespace(str);
+}
+
+const char* JsonReader::bind_object(const char* str, void* object, BindFind find, BindMember member)
 {
-    CPPJSON_ASSERT(nullptr != str);
-    CPPJSON_ASSERT(JsonReader::Invalid != value_);
-    if(JsonType::KeyValue != type()) {
-        return false;
+    // Members are dispatched by keys, and unknown members are validated and skipped
+    if('{' != str[0] || max_nesting_ < ++nesting_) {
+        return CPPJSON_NULL;
+    }
+    str = whitespace(str + 1);
+    if(str < end_ && '}' == str[0]) {
+        --nesting_;
+        return str + 1;
+    }
+    while(str < end_) {
+        if('"' != str[0]) {
+            return CPPJSON_NULL;
+        }
+        const char* key = str + 1;
+        str = scan_string(key);
+        if(CPPJSON_NULL == str) {
+            return CPPJSON_NULL;
+        }
+        uint32_t field = find(key, static_cast<uint64_t>(str - key));
+        str = whitespace(str + 1);
+        if(end_ <= str || ':' != str[0]) {
+            return CPPJSON_NULL;
+        }
+        str = whitespace(str + 1);
+        if(end_ <= str) {
+            return CPPJSON_NULL;
+        }
+        str = Invalid != field ? member(*this, str, object, field) : skip_element(str);
+        if(CPPJSON_NULL == str) {
+            return CPPJSON_NULL;
+        }
+        str = whitespace(str);
+        if(end_ <= str) {
+            return CPPJSON_NULL;
+        }
+        if('}' == str[0]) {
+            --nesting_;
+            return str + 1;
+        }
+        if(',' != str[0]) {
+            return CPPJSON_NULL;
+        }
+        str = whitespace(str + 1);
     }
-    return 0 == ::strncmp(str, data_ + values_[value_].start_, values_[value_].size_);
+    return CPPJSON_NULL;
 }
 
-JsonReader::JsonReader(int32_t max_nesting, CPPJSON_MALLOC_TYPE alloc, CPPJSON_FREE_TYPE dealloc)
-    : alloc_(alloc)
-    , dealloc_(dealloc)
-    , max_nesting_(max_nesting)
-    , nesting_(0)
+const char* JsonReader::bind_array(const char* str, void* array, BindElement element)
+{
+    if('[' != str[0] || max_nesting_ < ++nesting_) {
+        return CPPJSON_NULL;
+    }
+    str = whitespace(str + 1);
+    if(str < end_ && ']' == str[0]) {
+        --nesting_;
+        return str + 1;
+    }
+    while(str < end_) {
+        str = element(*this, str, array);
+        if(CPPJSON_NULL == str) {
+            return CPPJSON_NULL;
+        }
+        str = whitespace(str);
+        if(end_ <= str) {
+            return CPPJSON_NULL;
+        }
+        if(']' == str[0]) {
+            --nesting_;
+            return str + 1;
+        }
+        if(',' != str[0]) {
+            return CPPJSON_NULL;
+        }
+        str = whitespace(str + 1);
+        if(end_ <= str) {
+            return CPPJSON_NULL;
+        }
+    }
+    return CPPJSON_NULL;
+}
+
+const char* JsonReader::bind_bool(const char* str, bool& value)
+{
+    switch(str[0]) {
+    case 't':
+        value = true;
+        return parse_true(str);
+    case 'f':
+        value = false;
+        return parse_false(str);
+    default:
+        return CPPJSON_NULL;
+    }
+}
+
+const char* JsonReader::bind_int64(const char* str, int64_t& value)
+{
+    JsonType type;
+    const char* next = scan_number(type, str);
+    if(CPPJSON_NULL == next || JsonType::Integer != type) {
+        return CPPJSON_NULL;
+    }
+    std::from_chars_result result = std::from_chars(str, next, value);
+    return std::errc() == result.ec ? next : CPPJSON_NULL;
+}
+
+const char* JsonReader::bind_uint64(const char* str, uint64_t& value)
+{
+    JsonType type;
+    const char* next = scan_number(type, str);
+    if(CPPJSON_NULL == next || JsonType::Integer != type) {
+        return CPPJSON_NULL;
+    }
+    std::from_chars_result result = std::from_chars(str, next, value);
+    return std::errc() == result.ec ? next : CPPJSON_NULL;
+}
+
+const char* JsonReader::bind_float64(const char* str, double& value)
+{
+    JsonType type;
+    const char* next = scan_number(type, str);
+    if(CPPJSON_NULL == next) {
+        return CPPJSON_NULL;
+    }
+    value = decode_float(str, next);
+    return next;
+}
+
+const char* JsonReader::bind_string(const char* str, const char*& first, uint64_t& size, bool& escaped)
+{
+    if('"' != str[0]) {
+        return CPPJSON_NULL;
+    }
+    first = str + 1;
+    const char* close = scan_string(first, escaped);
+    if(CPPJSON_NULL == close) {
+        return CPPJSON_NULL;
+    }
+    size = static_cast<uint64_t>(close - first);
+    return close + 1;
+}
+
+uint64_t JsonReader::bind_unescape(const char* first, uint64_t size, char* out, uint64_t capacity)
+{
+    return unescape(first, first + size, out, capacity);
+}
+
+const char* JsonReader::bind_null(const char* str)
+{
+    return 'n' == str[0] ? parse_null(str) : CPPJSON_NULL;
+}
+#endif // CPPJSON_NO_BIND
+
+JsonWriter::JsonWriter(CPPJSON_MALLOC_TYPE alloc, CPPJSON_FREE_TYPE dealloc, CPPJSON_REALLOC_TYPE realloc)
+    : JsonWriter(JsonFunctions{alloc, dealloc, realloc}, JsonAllocator{})
+{
+}
+
+JsonWriter::JsonWriter(const JsonAllocator& allocator)
+    : JsonWriter(JsonFunctions{}, allocator)
+{
+}
+
+JsonWriter::JsonWriter(const JsonFunctions& functions, const JsonAllocator& allocator)
+    : functions_(functions)
+    , allocator_(allocator)
     , capacity_(0)
     , size_(0)
-    , values_(CPPJSON_NULL)
+    , buffer_(CPPJSON_NULL)
+    , comma_(false)
 {
-    CPPJSON_ASSERT(0 < max_nesting_);
-    if(CPPJSON_NULL == alloc_ || CPPJSON_NULL == dealloc_) {
-        alloc_ = ::malloc;
-        dealloc_ = ::free;
+    if(CPPJSON_NULL == allocator_.allocate_ || CPPJSON_NULL == allocator_.deallocate_) {
+        allocator_ = make_allocator(functions_);
     }
-    CPPJSON_ASSERT(CPPJSON_NULL != alloc_);
-    CPPJSON_ASSERT(CPPJSON_NULL != dealloc_);
 }
 
-JsonReader::~JsonReader()
+JsonWriter::~JsonWriter()
 {
-    dealloc_(values_);
-    values_ = CPPJSON_NULL;
+    deallocate(buffer_);
+    buffer_ = CPPJSON_NULL;
 }
 
-bool JsonReader::parse(const char* begin, const char* end)
+void JsonWriter::clear()
+{
+    size_ = 0;
+    comma_ = false;
+}
+
+bool JsonWriter::reserve(uint64_t capacity)
+{
+    if(capacity <= capacity_) {
+        return true;
+    }
+    if(SIZE_MAX < capacity) {
+        return false;
+    }
+    char* buffer = reinterpret_cast<char*>(reallocate(buffer_, static_cast<size_t>(size_), static_cast<size_t>(capacity)));
+    if(CPPJSON_NULL == buffer) {
+        return false;
+    }
+    buffer_ = buffer;
+    capacity_ = capacity;
+    return true;
+}
+
+const char* JsonWriter::data() const
+{
+    return buffer_;
+}
+
+uint64_t JsonWriter::size() const
+{
+    return size_;
+}
+
+bool JsonWriter::beginObject()
+{
+    if(!separate(1)) {
+        return false;
+    }
+    buffer_[size_++] = '{';
+    comma_ = false;
+    return true;
+}
+
+bool JsonWriter::endObject()
+{
+    if(!expand(1)) {
+        return false;
+    }
+    buffer_[size_++] = '}';
+    comma_ = true;
+    return true;
+}
+
+bool JsonWriter::beginArray()
+{
+    if(!separate(1)) {
+        return false;
+    }
+    buffer_[size_++] = '[';
+    comma_ = false;
+    return true;
+}
+
+bool JsonWriter::endArray()
+{
+    if(!expand(1)) {
+        return false;
+    }
+    buffer_[size_++] = ']';
+    comma_ = true;
+    return true;
+}
+
+bool JsonWriter::key(std::string_view key)
+{
+    if(!separate(key.size() + 3) || !write_string(key.data(), key.size())) {
+        return false;
+    }
+    buffer_[size_++] = ':';
+    comma_ = false;
+    return true;
+}
+
+bool JsonWriter::writeString(std::string_view value)
+{
+    return separate(value.size() + 2) && write_string(value.data(), value.size());
+}
+
+bool JsonWriter::writeInt64(int64_t value)
+{
+    if(!separate(20)) {
+        return false;
+    }
+    size_ = static_cast<uint64_t>(std::to_chars(buffer_ + size_, buffer_ + capacity_, value).ptr - buffer_);
+    return true;
+}
+
+bool JsonWriter::writeUInt64(uint64_t value)
+{
+    if(!separate(20)) {
+        return false;
+    }
+    size_ = static_cast<uint64_t>(std::to_chars(buffer_ + size_, buffer_ + capacity_, value).ptr - buffer_);
+    return true;
+}
+
+bool JsonWriter::writeFloat64(double value)
+{
+    if(!std::isfinite(value)) {
+        return writeNull();
+    }
+    // The shortest form is at most 24 characters like -2.2250738585072014e-308
+    if(!separate(32)) {
+        return false;
+    }
+    size_ = static_cast<uint64_t>(std::to_chars(buffer_ + size_, buffer_ + capacity_, value).ptr - buffer_);
+    return true;
+}
+
+bool JsonWriter::writeBool(bool value)
+{
+    return value ? writeRaw("true") : writeRaw("false");
+}
+
+bool JsonWriter::writeNull()
+{
+    return writeRaw("null");
+}
+
+bool JsonWriter::writeRaw(std::string_view json)
+{
+    if(!separate(json.size())) {
+        return false;
+    }
+    ::memcpy(buffer_ + size_, json.data(), json.size());
+    size_ += json.size();
+    return true;
+}
+
+bool JsonWriter::write(const JsonProxy& element)
+{
+    CPPJSON_ASSERT(element);
+    const JsonValue& value = element.values_[element.value_];
+    const char* str = element.data_ + value.start_;
+    switch(static_cast<JsonType>(value.type_)) {
+    case JsonType::Object:
+    case JsonType::Array: {
+        // The source is complete unless a projection dropped children
+        if(!element.reader_->projected_) {
+            const char* end = skip_aggregation(str, element.reader_->end_);
+            if(CPPJSON_NULL != end) {
+                return writeRaw(std::string_view(str, static_cast<size_t>(end - str)));
+            }
+        }
+        bool object = JsonType::Object == static_cast<JsonType>(value.type_);
+        if(!(object ? beginObject() : beginArray())) {
+            return false;
+        }
+        for(JsonProxy i = element.begin(); i; i = i.next()) {
+            if(!write(i)) {
+                return false;
+            }
+        }
+        return object ? endObject() : endArray();
+    }
+    case JsonType::KeyValue: {
+        // Keys in the document are already escaped
+        const JsonValue& key = element.values_[value.start_];
+        if(!separate(key.size_ + 3) || !write_raw_string(element.data_ + key.start_, key.size_)) {
+            return false;
+        }
+        buffer_[size_++] = ':';
+        comma_ = false;
+        return write(element.value());
+    }
+    case JsonType::ArrayValue:
+        return write(element.value());
+    case JsonType::String:
+        return separate(value.size_ + 2) && write_raw_string(str, value.size_);
+    default:
+        return writeRaw(std::string_view(str, static_cast<size_t>(value.size_)));
+    }
+}
+
+bool JsonWriter::minify(const char* begin, const char* end)
 {
     CPPJSON_ASSERT(CPPJSON_NULL != begin);
     CPPJSON_ASSERT(CPPJSON_NULL != end);
     CPPJSON_ASSERT(begin <= end);
-    begin_ = begin;
-    end_ = end;
-    size_ = 0;
+    if(!separate(static_cast<uint64_t>(end - begin))) {
+        return false;
+    }
+    size_ = static_cast<uint64_t>(minify_to(begin, end, buffer_ + size_) - buffer_);
+    return true;
+}
 
-    const char* str = parse_element(begin_);
-    if(CPPJSON_NULL == str) {
+bool JsonWriter::prettify(const char* begin, const char* end, uint32_t indent)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    if(!separate(static_cast<uint64_t>(end - begin))) {
         return false;
     }
-    str = whitespace(str);
-    return end_ <= str;
+    uint64_t depth = 0;
+    const char* str = skip_whitespace(begin, end);
+    while(str < end) {
+        const char* next = str + 1;
+        switch(str[0]) {
+        case '{':
+        case '[':
+            next = skip_whitespace(next, end);
+            if(next < end && (('{' == str[0] && '}' == next[0]) || ('[' == str[0] && ']' == next[0]))) {
+                if(!expand(2)) {
+                    return false;
+                }
+                buffer_[size_++] = str[0];
+                buffer_[size_++] = next[0];
+                ++next;
+                break;
+            }
+            if(!expand(1)) {
+                return false;
+            }
+            buffer_[size_++] = str[0];
+            ++depth;
+            if(!newline(depth, indent)) {
+                return false;
+            }
+            break;
+        case '}':
+        case ']':
+            depth = 0 < depth ? depth - 1 : 0;
+            if(!newline(depth, indent) || !expand(1)) {
+                return false;
+            }
+            buffer_[size_++] = str[0];
+            break;
+        case ',':
+            if(!expand(1)) {
+                return false;
+            }
+            buffer_[size_++] = ',';
+            if(!newline(depth, indent)) {
+                return false;
+            }
+            break;
+        case ':':
+            if(!expand(2)) {
+                return false;
+            }
+            buffer_[size_++] = ':';
+            buffer_[size_++] = ' ';
+            break;
+        default: {
+            // Strings and numbers are copied in bulk
+            if('"' == str[0]) {
+                next = skip_string(str, end);
+                next = CPPJSON_NULL == next ? end : next;
+            } else {
+                next = skip_token(str, end);
+                next = str < next ? next : str + 1;
+            }
+            uint64_t size = static_cast<uint64_t>(next - str);
+            if(!expand(size)) {
+                return false;
+            }
+            ::memcpy(buffer_ + size_, str, size);
+            size_ += size;
+        } break;
+        }
+        str = skip_whitespace(next, end);
+    }
+    return true;
+}
+
+uint64_t JsonWriter::minifyInPlace(char* begin, char* end)
+{
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    return static_cast<uint64_t>(minify_to(begin, end, begin) - begin);
+}
+
+void* JsonWriter::allocate(size_t size) const
+{
+    return allocator_.allocate_(allocator_.context_, size);
+}
+
+void JsonWriter::deallocate(void* ptr) const
+{
+    allocator_.deallocate_(allocator_.context_, ptr);
+}
+
+void* JsonWriter::reallocate(void* ptr, size_t size, size_t new_size) const
+{
+    if(CPPJSON_NULL != allocator_.reallocate_) {
+        return allocator_.reallocate_(allocator_.context_, ptr, size, new_size);
+    }
+    void* result = allocate(new_size);
+    if(CPPJSON_NULL == result) {
+        return CPPJSON_NULL;
+    }
+    if(0 < size) {
+        ::memcpy(result, ptr, size);
+    }
+    deallocate(ptr);
+    return result;
 }
 
-JsonProxy JsonReader::root() const
+bool JsonWriter::expand(uint64_t size)
 {
-    if(size_ <= 0) {
-        return {Invalid, CPPJSON_NULL, CPPJSON_NULL};
+    if((capacity_ - size_) < size) {
+        return reserve(size_ + size + (capacity_ >> 1) + Expand);
     }
-    return {0, begin_, values_};
+    return true;
 }
 
-uint32_t JsonReader::add()
+bool JsonWriter::separate(uint64_t size)
 {
-    if(capacity_ <= size_) {
-        uint32_t capacity = capacity_ + Expand;
-        JsonValue* values = reinterpret_cast<JsonValue*>(alloc_(sizeof(JsonValue) * capacity));
-        if(0 < capacity_) {
-            ::memcpy(values, values_, sizeof(JsonValue) * capacity_);
-        }
-        dealloc_(values_);
-        capacity_ = capacity;
-        values_ = values;
+    // A comma and the value
+    if(!expand(size + 1)) {
+        return false;
     }
-    uint32_t current = size_;
-    ++size_;
-    return current;
+    if(comma_) {
+        buffer_[size_++] = ',';
+    }
+    comma_ = true;
+    return true;
 }
 
-void JsonReader::add_value(uint32_t set, uint32_t value)
+bool JsonWriter::newline(uint64_t depth, uint32_t indent)
 {
-    ++values_[set].size_;
-    while(Invalid != values_[set].next_) {
-        set = values_[set].next_;
+    uint64_t spaces = depth * indent;
+    if(!expand(spaces + 1)) {
+        return false;
     }
-    values_[set].next_ = value;
+    buffer_[size_++] = '\n';
+    ::memset(buffer_ + size_, 0x20, static_cast<size_t>(spaces));
+    size_ += spaces;
+    return true;
 }
 
-const char* JsonReader::whitespace(const char* str)
+bool JsonWriter::write_string(const char* str, uint64_t size)
 {
-    while(str < end_) {
-        switch(str[0]) {
-        case 0x20:
+    // The capacity for the string without escapes is reserved by the caller, and extended at each escape
+    static constexpr char Hex[] = "0123456789abcdef";
+    const char* end = str + size;
+    buffer_[size_++] = '"';
+    for(;;) {
+        const char* run = find_escape(str, end);
+        uint64_t length = static_cast<uint64_t>(run - str);
+        ::memcpy(buffer_ + size_, str, length);
+        size_ += length;
+        if(end <= run) {
+            break;
+        }
+        // An escape is at most 6 characters, followed by the rest and the closing quote
+        str = run + 1;
+        if(!expand(6 + static_cast<uint64_t>(end - str) + 2)) {
+            return false;
+        }
+        char* out = buffer_ + size_;
+        uint8_t c = static_cast<uint8_t>(run[0]);
+        out[0] = '\\';
+        switch(c) {
+        case '"':
+        case '\\':
+            out[1] = static_cast<char>(c);
+            size_ += 2;
+            break;
+        case 0x08:
+            out[1] = 'b';
+            size_ += 2;
+            break;
+        case 0x0C:
+            out[1] = 'f';
+            size_ += 2;
+            break;
         case 0x0A:
+            out[1] = 'n';
+            size_ += 2;
+            break;
         case 0x0D:
+            out[1] = 'r';
+            size_ += 2;
+            break;
         case 0x09:
-            ++str;
+            out[1] = 't';
+            size_ += 2;
             break;
         default:
-            return str;
+            out[1] = 'u';
+            out[2] = '0';
+            out[3] = '0';
+            out[4] = Hex[c >> 4];
+            out[5] = Hex[c & 0x0FU];
+            size_ += 6;
+            break;
         }
     }
-    return str;
+    buffer_[size_++] = '"';
+    return true;
 }
 
-const char* JsonReader::parse_utf8(const char* str)
+bool JsonWriter::write_raw_string(const char* str, uint64_t size)
 {
-    const uint8_t* u = reinterpret_cast<const uint8_t*>(str);
+    buffer_[size_++] = '"';
+    ::memcpy(buffer_ + size_, str, static_cast<size_t>(size));
+    size_ += size;
+    buffer_[size_++] = '"';
+    return true;
+}
 
-    if(0x20U <= u[0] && u[0] < 0x80U) {
-        return str + 1;
-    }
+#ifndef CPPJSON_NO_THREADS
+JsonLineReader::JsonLineReader(uint32_t threads, int32_t max_nesting, CPPJSON_MALLOC_TYPE alloc, CPPJSON_FREE_TYPE dealloc, CPPJSON_REALLOC_TYPE realloc)
+    : JsonLineReader(threads, max_nesting, JsonFunctions{alloc, dealloc, realloc}, JsonAllocator{})
+{
+}
 
-    if(0xC2U <= u[0] && u[0] <= 0xDFU) {
-        if(end_ <= (str + 1)) {
-            return CPPJSON_NULL;
-        }
-        return str + 2;
-    }
+JsonLineReader::JsonLineReader(uint32_t threads, int32_t max_nesting, const JsonAllocator& allocator)
+    : JsonLineReader(threads, max_nesting, JsonFunctions{}, allocator)
+{
+}
 
-    if(0xE0U <= u[0] && u[0] < 0xF0U) {
-        if(end_ <= (str + 2)) {
-            return CPPJSON_NULL;
-        }
-        if(0xE0U == u[0] && 0x80U <= u[1] && u[1] <= 0x9FU) {
-            return CPPJSON_NULL;
-        }
-        return str + 3;
+JsonLineReader::JsonLineReader(uint32_t threads, int32_t max_nesting, const JsonFunctions& functions, const JsonAllocator& allocator)
+    : functions_(functions)
+    , allocator_(allocator)
+    , begin_(CPPJSON_NULL)
+    , threads_(threads)
+    , workers_(CPPJSON_NULL)
+    , pool_(CPPJSON_NULL)
+    , chunk_capacity_(0)
+    , chunk_size_(0)
+    , chunks_(CPPJSON_NULL)
+    , record_capacity_(0)
+    , record_size_(0)
+    , records_(CPPJSON_NULL)
+    , generation_(0)
+    , running_(0)
+    , quit_(false)
+    , next_(0)
+{
+    if(CPPJSON_NULL == allocator_.allocate_ || CPPJSON_NULL == allocator_.deallocate_) {
+        allocator_ = make_allocator(functions_);
     }
-
-    if(0xF0U <= u[0] && u[0] < 0xF4U) {
-        if(end_ <= (str + 3)) {
-            return CPPJSON_NULL;
-        }
-        if(0xF0U == u[0] && 0x80U <= u[1] && u[1] <= 0x8FU) {
-            return CPPJSON_NULL;
-        }
-        if(0xF4U == u[0] && 0x90U <= u[1]) {
-            return CPPJSON_NULL;
+    if(threads_ <= 0) {
+        threads_ = std::thread::hardware_concurrency();
+        threads_ = 0 < threads_ ? threads_ : 1;
+    }
+    // Workers which cannot be allocated or started are dropped, and parse fails without any worker
+    workers_ = reinterpret_cast<Worker*>(allocate(sizeof(Worker) * threads_));
+    threads_ = CPPJSON_NULL != workers_ ? threads_ : 0;
+    for(uint32_t i = 0; i < threads_; ++i) {
+        void* reader = allocate(sizeof(JsonReader));
+        if(CPPJSON_NULL == reader) {
+            threads_ = i;
+            break;
         }
-        return str + 4;
+        workers_[i].reader_ = new(reader) JsonReader(max_nesting, allocator_);
+        workers_[i].capacity_ = 0;
+        workers_[i].size_ = 0;
+        workers_[i].roots_ = CPPJSON_NULL;
+        workers_[i].failed_ = false;
     }
-    return CPPJSON_NULL;
+    // The caller works as the first worker
+    pool_ = 1 < threads_ ? reinterpret_cast<std::thread*>(allocate(sizeof(std::thread) * threads_)) : CPPJSON_NULL;
+    uint32_t started = 1;
+    while(CPPJSON_NULL != pool_ && started < threads_ && start_thread(&pool_[started], &JsonLineReader::run, this, started)) {
+        ++started;
+    }
+    for(uint32_t i = started; i < threads_; ++i) {
+        workers_[i].reader_->~JsonReader();
+        deallocate(workers_[i].reader_);
+    }
+    threads_ = started < threads_ ? started : threads_;
 }
 
-const char* JsonReader::parse_element(const char* str)
+JsonLineReader::~JsonLineReader()
 {
-    str = whitespace(str);
-    if(end_ <= str) {
-        return CPPJSON_NULL;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
     }
-    auto [n, v] = parse_value(str);
-    str = n;
-    if(CPPJSON_NULL == str) {
-        return CPPJSON_NULL;
+    start_.notify_all();
+    for(uint32_t i = 1; i < threads_; ++i) {
+        pool_[i].join();
+        pool_[i].~thread();
     }
-    return whitespace(str);
+    deallocate(pool_);
+    pool_ = CPPJSON_NULL;
+    for(uint32_t i = 0; i < threads_; ++i) {
+        deallocate(workers_[i].roots_);
+        workers_[i].reader_->~JsonReader();
+        deallocate(workers_[i].reader_);
+    }
+    deallocate(workers_);
+    workers_ = CPPJSON_NULL;
+    deallocate(records_);
+    records_ = CPPJSON_NULL;
+    deallocate(chunks_);
+    chunks_ = CPPJSON_NULL;
 }
 
-std::tuple<const char*, uint32_t> JsonReader::parse_value(const char* str)
+void JsonLineReader::setNumberDecoding(bool enable)
 {
-    const char* begin = str;
-    const char* next = CPPJSON_NULL;
-    JsonType type;
-    switch(str[0]) {
-    case '"':
-        return parse_string(str);
-    case '-': {
-        ++str;
-        if(end_ <= str || str[0] < '0' || '9' < str[0]) {
-            return InvalidPair;
-        }
-        switch(str[0]) {
-        case '0': {
-            next = parse_zero_number(type, str);
-        } break;
-        default:
-            next = parse_number(type, str);
-            break;
-        }
-    } break;
-    case '0':
-        next = parse_zero_number(type, str);
-        break;
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-    case '8':
-    case '9':
-        next = parse_number(type, str);
-        break;
-    case '{':
-        return parse_object(str);
-    case '[':
-        return parse_array(str);
-    case 't':
-        type = JsonType::True;
-        next = parse_true(str);
-        break;
-    case 'f':
-        type = JsonType::False;
-        next = parse_false(str);
-        break;
-    case 'n':
-        type = JsonType::Null;
-        next = parse_null(str);
-        break;
-    default:
-        return InvalidPair;
-    }
-    if(CPPJSON_NULL == next) {
-        return InvalidPair;
+    for(uint32_t i = 0; i < threads_; ++i) {
+        workers_[i].reader_->setNumberDecoding(enable);
     }
-
-    uint32_t value = add();
-    values_[value].start_ = reinterpret_cast<uint64_t>(begin) - reinterpret_cast<uint64_t>(begin_);
-    values_[value].size_ = reinterpret_cast<uint64_t>(next) - reinterpret_cast<uint64_t>(begin);
-    values_[value].next_ = Invalid;
-    values_[value].type_ = static_cast<uint32_t>(type);
-    return {next, value};
 }
 
-std::tuple<const char*, uint32_t> JsonReader::parse_string(const char* str)
+void JsonLineReader::setStackBudget(uint64_t bytes)
 {
-    CPPJSON_ASSERT('"' == str[0]);
-    ++str;
-    const char* begin = str;
-    uint32_t value = add();
-    values_[value].start_ = reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_);
-    values_[value].next_ = Invalid;
-    values_[value].type_ = static_cast<uint32_t>(JsonType::String);
-    while(str < end_) {
-        switch(str[0]) {
-        case '"':
-            values_[value].size_ = reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin);
-            return {str + 1, value};
-        case '\\': {
-            const char* next = str + 1;
-            if(end_ <= next) {
-                return InvalidPair;
-            }
-            switch(next[0]) {
-            case '"':
-            case '\\':
-            case '/':
-            case 'b':
-            case 'f':
-            case 'n':
-            case 'r':
-            case 't':
-                str = next + 1;
-                break;
-            case 'u':
-                str = parse_4hex(next + 1);
-                if(CPPJSON_NULL == str) {
-                    return InvalidPair;
-                }
-                ++str;
-                break;
-            default:
-                return InvalidPair;
-            }
-        } break;
-        default:
-            str = parse_utf8(str);
-            if(CPPJSON_NULL == str) {
-                return InvalidPair;
-            }
-            break;
-        }
+    for(uint32_t i = 0; i < threads_; ++i) {
+        workers_[i].reader_->setStackBudget(bytes);
     }
-    return InvalidPair;
 }
 
-const char* JsonReader::parse_4hex(const char* str)
+bool JsonLineReader::parse(const char* begin, const char* end)
 {
-    uint32_t count = 0;
-    while(str < end_) {
-        switch(str[0]) {
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-        case 'A':
-        case 'B':
-        case 'C':
-        case 'D':
-        case 'E':
-        case 'F':
-        case 'a':
-        case 'b':
-        case 'c':
-        case 'd':
-        case 'e':
-        case 'f':
-            ++count;
-            break;
-        default:
-            return CPPJSON_NULL;
+    CPPJSON_ASSERT(CPPJSON_NULL != begin);
+    CPPJSON_ASSERT(CPPJSON_NULL != end);
+    CPPJSON_ASSERT(begin <= end);
+    begin_ = begin;
+    record_size_ = 0;
+    if(threads_ <= 0) {
+        return false;
+    }
+
+    // Split the batch into chunks at newlines
+    uint64_t size = static_cast<uint64_t>(end - begin);
+    uint64_t chunks = static_cast<uint64_t>(threads_) * ChunksPerThread;
+    uint64_t chunk = (size + chunks - 1) / chunks;
+    chunk = chunk < MinChunk ? MinChunk : chunk;
+    chunks = (size + chunk - 1) / chunk;
+    chunks = 0 < chunks ? chunks : 1;
+    if(chunk_capacity_ < chunks) {
+        Chunk* new_chunks = reinterpret_cast<Chunk*>(reallocate(chunks_, 0, sizeof(Chunk) * chunks));
+        if(CPPJSON_NULL == new_chunks) {
+            return false;
         }
-        if(4 <= count) {
-            return str;
+        chunks_ = new_chunks;
+        chunk_capacity_ = static_cast<uint32_t>(chunks);
+    }
+    chunk_size_ = 0;
+    const char* str = begin;
+    while(str < end) {
+        const char* next = static_cast<uint64_t>(end - str) <= chunk ? end : str + chunk;
+        if(next < end) {
+            next = reinterpret_cast<const char*>(::memchr(next, '\n', end - next));
+            next = CPPJSON_NULL == next ? end : next + 1;
         }
-        ++str;
+        chunks_[chunk_size_] = {str, next, 0, 0, 0};
+        ++chunk_size_;
+        str = next;
+    }
+    for(uint32_t i = 0; i < threads_; ++i) {
+        workers_[i].reader_->clear();
+        workers_[i].size_ = 0;
+        workers_[i].failed_ = false;
     }
-    return CPPJSON_NULL;
-}
 
-const char* JsonReader::parse_zero_number(JsonType& type, const char* str)
-{
-    CPPJSON_ASSERT('0' == str[0]);
-    ++str;
-    if(end_ <= str) {
-        return str;
+    // Run the workers, and wait for them
+    next_.store(0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+        running_ = threads_ - 1;
     }
-    switch(str[0]) {
-    case '0':
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-    case '8':
-    case '9':
-        return CPPJSON_NULL;
-    case '.':
-        type = JsonType::Number;
-        return parse_fraction(str);
-    case 'e':
-    case 'E':
-        type = JsonType::Number;
-        return parse_exponent(str);
-    default:
-        type = JsonType::Integer;
-        return str;
+    start_.notify_all();
+    work(0);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return running_ <= 0; });
+    }
+
+    // Gather the records in the order of chunks
+    uint64_t records = 0;
+    for(uint32_t i = 0; i < chunk_size_; ++i) {
+        records += chunks_[i].size_;
     }
+    if(record_capacity_ < records) {
+        Record* new_records = reinterpret_cast<Record*>(reallocate(records_, 0, sizeof(Record) * records));
+        if(CPPJSON_NULL == new_records) {
+            return false;
+        }
+        records_ = new_records;
+        record_capacity_ = records;
+    }
+    bool result = true;
+    for(uint32_t i = 0; i < chunk_size_; ++i) {
+        const Chunk& c = chunks_[i];
+        const Worker& worker = workers_[c.worker_];
+        for(uint64_t j = 0; j < c.size_; ++j) {
+            uint32_t root = worker.roots_[c.first_ + j];
+            records_[record_size_] = {c.worker_, root};
+            ++record_size_;
+            result = result && JsonReader::Invalid != root;
+        }
+    }
+    for(uint32_t i = 0; i < threads_; ++i) {
+        result = result && !workers_[i].failed_;
+    }
+    return result;
+}
+
+uint32_t JsonLineReader::threads() const
+{
+    return threads_;
 }
 
-const char* JsonReader::parse_number(JsonType& type, const char* str)
+uint64_t JsonLineReader::size() const
 {
-    CPPJSON_ASSERT('1' <= str[0] && str[0] <= '9');
-    ++str;
-    while(str < end_) {
-        switch(str[0]) {
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-            ++str;
-            break;
-        case '.':
-            type = JsonType::Number;
-            return parse_fraction(str);
-        case 'e':
-        case 'E':
-            type = JsonType::Number;
-            return parse_exponent(str);
-        default:
-            type = JsonType::Integer;
-            return str;
-        }
-    }
-    type = JsonType::Integer;
-    return str;
+    return record_size_;
 }
 
-const char* JsonReader::parse_fraction(const char* str)
+bool JsonLineReader::valid(uint64_t index) const
 {
-    CPPJSON_ASSERT('.' == str[0]);
-    str = parse_digits(str + 1);
-    if(CPPJSON_NULL == str || end_ <= str) {
-        return str;
+    CPPJSON_ASSERT(index < record_size_);
+    return JsonReader::Invalid != records_[index].root_;
+}
+
+JsonProxy JsonLineReader::root(uint64_t index) const
+{
+    CPPJSON_ASSERT(index < record_size_);
+    const Record& record = records_[index];
+    if(JsonReader::Invalid == record.root_) {
+        return {JsonReader::Invalid, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL, CPPJSON_NULL};
     }
-    switch(str[0]) {
-    case 'e':
-    case 'E':
-        return parse_exponent(str);
-    default:
-        return str;
+    const JsonReader* reader = workers_[record.worker_].reader_;
+    return {record.root_, begin_, reader->values_, reader->numbers_, reader};
+}
+
+bool JsonLineReader::buildTables()
+{
+    bool result = true;
+    for(uint32_t i = 0; i < threads_; ++i) {
+        result = workers_[i].reader_->buildTables() && result;
     }
+    return result;
 }
 
-const char* JsonReader::parse_exponent(const char* str)
+void* JsonLineReader::allocate(size_t size) const
 {
-    CPPJSON_ASSERT('e' == str[0] || 'E' == str[0]);
-    ++str;
-    if(end_ <= str) {
+    return allocator_.allocate_(allocator_.context_, size);
+}
+
+void JsonLineReader::deallocate(void* ptr) const
+{
+    allocator_.deallocate_(allocator_.context_, ptr);
+}
+
+void* JsonLineReader::reallocate(void* ptr, size_t size, size_t new_size) const
+{
+    if(CPPJSON_NULL != allocator_.reallocate_) {
+        return allocator_.reallocate_(allocator_.context_, ptr, size, new_size);
+    }
+    void* result = allocate(new_size);
+    if(CPPJSON_NULL == result) {
         return CPPJSON_NULL;
     }
-    if(str[0] == '-' || str[0] == '+') {
-        ++str;
-        if(end_ <= str) {
-            return CPPJSON_NULL;
-        }
+    if(0 < size) {
+        ::memcpy(result, ptr, size);
     }
-    return parse_digits(str);
+    deallocate(ptr);
+    return result;
 }
 
-const char* JsonReader::parse_digits(const char* str)
+void JsonLineReader::run(uint32_t worker)
 {
-    uint32_t count = 0;
-    while(str < end_) {
-        switch(str[0]) {
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-            ++str;
-            ++count;
-            break;
-        default:
-            return (0 < count) ? str : CPPJSON_NULL;
+    uint64_t generation = 0;
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [this, generation] { return quit_ || generation != generation_; });
+            if(quit_) {
+                return;
+            }
+            generation = generation_;
+        }
+        work(worker);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --running_;
         }
+        done_.notify_one();
     }
-    return (0 < count) ? str : CPPJSON_NULL;
 }
 
-std::tuple<const char*, uint32_t> JsonReader::parse_object(const char* str)
+void JsonLineReader::work(uint32_t worker)
 {
-    CPPJSON_ASSERT('{' == str[0]);
-    if(max_nesting_ < ++nesting_) {
-        return InvalidPair;
+    for(;;) {
+        uint32_t chunk = next_.fetch_add(1);
+        if(chunk_size_ <= chunk) {
+            return;
+        }
+        if(!parse(workers_[worker], chunks_[chunk])) {
+            workers_[worker].failed_ = true;
+        }
+        chunks_[chunk].worker_ = worker;
     }
-    uint32_t object = add();
-    values_[object].start_ = reinterpret_cast<uint64_t>(str) - reinterpret_cast<uint64_t>(begin_);
-    values_[object].size_ = 0;
-    values_[object].next_ = Invalid;
-    values_[object].type_ = static_cast<uint32_t>(JsonType::Object);
+}
 
-    ++str;
-    bool needs_member = false;
-    bool needs_comma = false;
-    while(str < end_) {
-        str = whitespace(str);
-        if(end_ <= str) {
-            return InvalidPair;
+bool JsonLineReader::parse(Worker& worker, Chunk& chunk)
+{
+    chunk.first_ = worker.size_;
+    chunk.size_ = 0;
+    const char* str = chunk.begin_;
+    while(str < chunk.end_) {
+        const char* end = reinterpret_cast<const char*>(::memchr(str, '\n', chunk.end_ - str));
+        end = CPPJSON_NULL == end ? chunk.end_ : end;
+        const char* line = str;
+        str = end + 1;
+        // Skip lines which have only whitespaces
+        while(line < end && (' ' == line[0] || '\t' == line[0] || '\r' == line[0])) {
+            ++line;
         }
-        switch(str[0]) {
-        case '}':
-            --nesting_;
-            if(!needs_member) {
-                return {str + 1, object};
-            } else {
-                return InvalidPair;
-            }
-        case '"': {
-            if(needs_comma) {
-                return InvalidPair;
-            }
-            auto [n, v] = parse_member(str);
-            str = n;
-            if(CPPJSON_NULL == str) {
-                return InvalidPair;
-            }
-            add_value(object, v);
-            needs_member = false;
-            needs_comma = true;
-        } break;
-        case ',':
-            if(needs_member) {
-                return InvalidPair;
+        if(end <= line) {
+            continue;
+        }
+        if(worker.capacity_ <= worker.size_) {
+            uint64_t capacity = worker.capacity_ < JsonReader::Expand ? JsonReader::Expand : worker.capacity_ * 2;
+            uint32_t* roots = reinterpret_cast<uint32_t*>(reallocate(worker.roots_, sizeof(uint32_t) * worker.size_, sizeof(uint32_t) * capacity));
+            if(CPPJSON_NULL == roots) {
+                return false;
             }
-            ++str;
-            needs_member = true;
-            needs_comma = false;
-            break;
-        default:
-            return InvalidPair;
+            worker.roots_ = roots;
+            worker.capacity_ = capacity;
         }
+        worker.roots_[worker.size_] = worker.reader_->append(begin_, line, end);
+        ++worker.size_;
+        ++chunk.size_;
     }
-    return InvalidPair;
+    return true;
 }
 
-std::tuple<const char*, uint32_t> JsonReader::parse_member(const char* str)
+JsonReaderPool::JsonReaderPool(uint32_t max_idle, uint64_t high_water, int32_t max_nesting, CPPJSON_MALLOC_TYPE alloc, CPPJSON_FREE_TYPE dealloc, CPPJSON_REALLOC_TYPE realloc)
+    : JsonReaderPool(max_idle, high_water, max_nesting, JsonFunctions{alloc, dealloc, realloc}, JsonAllocator{})
 {
-    uint32_t keyvalue = add();
-    values_[keyvalue].start_ = Invalid;
-    values_[keyvalue].size_ = Invalid;
-    values_[keyvalue].next_ = Invalid;
-    values_[keyvalue].type_ = static_cast<uint32_t>(JsonType::KeyValue);
+}
 
-    auto [n0, v0] = parse_string(str);
-    str = n0;
-    if(CPPJSON_NULL == str) {
-        return InvalidPair;
-    }
-    values_[keyvalue].start_ = v0;
-    str = whitespace(str);
-    if(end_ <= str || ':' != str[0]) {
-        return InvalidPair;
-    }
-    str = whitespace(str + 1);
-    if(end_ <= str) {
-        return InvalidPair;
-    }
-    auto [n1, v1] = parse_value(str);
-    values_[keyvalue].size_ = v1;
-    return {n1, keyvalue};
+JsonReaderPool::JsonReaderPool(uint32_t max_idle, uint64_t high_water, int32_t max_nesting, const JsonAllocator& allocator)
+    : JsonReaderPool(max_idle, high_water, max_nesting, JsonFunctions{}, allocator)
+{
 }
 
-std::tuple<const char*, uint32_t> JsonReader::parse_array(const char* str)
+JsonReaderPool::JsonReaderPool(uint32_t max_idle, uint64_t high_water, int32_t max_nesting, const JsonFunctions& functions, const JsonAllocator& allocator)
+    : functions_(functions)
+    , allocator_(allocator)
+    , max_idle_(max_idle)
+    , high_water_(high_water)
+    , max_nesting_(max_nesting)
+    , idle_size_(0)
+    , idle_(CPPJSON_NULL)
+    , statistics_{0, 0, 0, 0, 0, 0}
 {
-    CPPJSON_ASSERT('[' == str[0]);
-    if(max_nesting_ < ++nesting_) {
-        return InvalidPair;
+    if(CPPJSON_NULL == allocator_.allocate_ || CPPJSON_NULL == allocator_.deallocate_) {
+        allocator_ = make_allocator(functions_);
     }
-    uint32_t object = add();
-    values_[object].start_ = reinterpret_cast<uint64_t>(str);
-    values_[object].size_ = 0;
-    values_[object].next_ = Invalid;
-    values_[object].type_ = static_cast<uint32_t>(JsonType::Array);
-    ++str;
-    bool needs_value = false;
-    bool needs_comma = false;
-    while(str < end_) {
-        str = whitespace(str);
-        if(end_ <= str) {
-            return InvalidPair;
-        }
-        switch(str[0]) {
-        case ']':
-            --nesting_;
-            if(!needs_value) {
-                return {str + 1, object};
-            } else {
-                return InvalidPair;
-            }
-        case ',':
-            if(needs_value) {
-                return InvalidPair;
-            }
-            ++str;
-            needs_value = true;
-            needs_comma = false;
-            break;
-        default:
-            if(needs_comma) {
-                return InvalidPair;
-            }
-            auto [n, v] = parse_array_value(str);
-            str = n;
-            if(CPPJSON_NULL == str) {
-                return InvalidPair;
-            }
-            add_value(object, v);
-            needs_value = false;
-            needs_comma = true;
-            break;
-        }
+    if(0 < max_idle_) {
+        idle_ = reinterpret_cast<JsonReader**>(allocate(sizeof(JsonReader*) * max_idle_));
+        // Readers are not kept without the list
+        max_idle_ = CPPJSON_NULL != idle_ ? max_idle_ : 0;
     }
-    return InvalidPair;
 }
 
-std::tuple<const char*, uint32_t> JsonReader::parse_array_value(const char* str)
+JsonReaderPool::~JsonReaderPool()
 {
-    uint32_t arrayvalue = add();
-    values_[arrayvalue].start_ = Invalid;
-    values_[arrayvalue].size_ = Invalid;
-    values_[arrayvalue].next_ = Invalid;
-    values_[arrayvalue].type_ = static_cast<uint32_t>(JsonType::ArrayValue);
-
-    auto [n0, v0] = parse_value(str);
-    str = n0;
-    if(CPPJSON_NULL == str) {
-        return InvalidPair;
-    }
-    values_[arrayvalue].size_ = v0;
-    return {n0, arrayvalue};
+    trim();
+    deallocate(idle_);
+    idle_ = CPPJSON_NULL;
 }
 
-const char* JsonReader::parse_true(const char* str)
+JsonReader* JsonReaderPool::acquire()
 {
-    CPPJSON_ASSERT('t' == str[0]);
-    if(end_ <= (str + 3)) {
-        return CPPJSON_NULL;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++statistics_.acquires_;
+        if(0 < idle_size_) {
+            ++statistics_.reuses_;
+            --idle_size_;
+            return idle_[idle_size_];
+        }
     }
-    if('r' == str[1] && 'u' == str[2] && 'e' == str[3]) {
-        return str + 4;
+    void* reader = allocate(sizeof(JsonReader));
+    if(CPPJSON_NULL == reader) {
+        return CPPJSON_NULL;
     }
-    return CPPJSON_NULL;
+    return new(reader) JsonReader(max_nesting_, allocator_);
 }
 
-const char* JsonReader::parse_false(const char* str)
+void JsonReaderPool::release(JsonReader* reader)
 {
-    CPPJSON_ASSERT('f' == str[0]);
-    if(end_ <= (str + 4)) {
-        return CPPJSON_NULL;
+    if(CPPJSON_NULL == reader) {
+        return;
     }
-    if('a' == str[1] && 'l' == str[2] && 's' == str[3] && 'e' == str[4]) {
-        return str + 5;
+    // Shrink outside the lock, only the reader's own buffers are touched
+    uint64_t memory = reader->memory();
+    reader->shrink(high_water_);
+    bool shrunk = reader->memory() < memory;
+    // Settings of the borrower are restored to the defaults, so that the next acquire gets a reader like a new one
+    reader->setGrowth(JsonReader::Expand, JsonReader::Growth);
+    reader->setStackBudget(JsonReader::StackBudget);
+    reader->setStructuralIndex(false);
+    reader->setNumberDecoding(false);
+    reader->setProjection(CPPJSON_NULL);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statistics_.shrinks_ += shrunk ? 1 : 0;
+        if(idle_size_ < max_idle_) {
+            idle_[idle_size_] = reader;
+            ++idle_size_;
+            return;
+        }
+        ++statistics_.destroys_;
     }
-    return CPPJSON_NULL;
+    destroy(reader);
 }
 
-const char* JsonReader::parse_null(const char* str)
+void JsonReaderPool::trim()
 {
-    CPPJSON_ASSERT('n' == str[0]);
-    if(end_ <= (str + 3)) {
-        return CPPJSON_NULL;
+    for(;;) {
+        JsonReader* reader = CPPJSON_NULL;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(idle_size_ <= 0) {
+                return;
+            }
+            --idle_size_;
+            reader = idle_[idle_size_];
+            ++statistics_.destroys_;
+        }
+        destroy(reader);
     }
-    if('u' == str[1] && 'l' == str[2] && 'l' == str[3]) {
-        return str + 4;
+}
+
+JsonReaderPool::Statistics JsonReaderPool::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Statistics statistics = statistics_;
+    statistics.idle_ = idle_size_;
+    for(uint32_t i = 0; i < idle_size_; ++i) {
+        statistics.memory_ += idle_[i]->memory();
     }
-    return CPPJSON_NULL;
+    return statistics;
 }
 
+void* JsonReaderPool::allocate(size_t size) const
+{
+    return allocator_.allocate_(allocator_.context_, size);
+}
+
+void JsonReaderPool::deallocate(void* ptr) const
+{
+    allocator_.deallocate_(allocator_.context_, ptr);
+}
+
+void JsonReaderPool::destroy(JsonReader* reader)
+{
+    reader->~JsonReader();
+    deallocate(reader);
+}
+#endif // CPPJSON_NO_THREADS
 } // namespace cppjson
 #endif // CPPJSON_IMPLEMENTATION
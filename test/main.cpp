@@ -2,9 +2,15 @@
 #define CPPJSON_IMPLEMENTATION
 #include "cppjson.h"
 
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
+#include <optional>
 #include <string>
 #include <vector>
+#ifndef CPPJSON_NO_THREADS
+#    include <thread>
+#endif // CPPJSON_NO_THREADS
 struct File
 {
     enum class Type
@@ -113,6 +119,9 @@ void test(const std::vector<File>& files)
         fclose(f);
         printf("[%zd] %s", i, file.path_.c_str());
         bool result = reader.parse(data, data + size);
+        cppjson::JsonStatus status = reader.validate(data, data + size);
+        assert(result == static_cast<bool>(status));
+        (void)status;
         switch(file.type_) {
             case File::Type::Valid:
                 assert(result);
@@ -285,8 +294,1509 @@ void test(const char* path)
     ::free(data);
 }
 
+void test_reserve()
+{
+    static const char json[] = "{\"a\": [1, 2, 3], \"b\": {\"c\": null}}";
+    const char* end = json + sizeof(json) - 1;
+    cppjson::JsonReader reader;
+    uint64_t estimated = cppjson::JsonReader::estimate(json, end);
+    bool result = reader.reserve(estimated);
+    assert(result);
+    uint32_t capacity = reader.capacity();
+    result = reader.parse(json, end);
+    assert(result);
+    assert(capacity == reader.capacity());
+
+    cppjson::JsonReader linear;
+    linear.setGrowth(1, 0);
+    result = linear.parse(json, end);
+    assert(result);
+    assert(linear.capacity() <= estimated);
+    (void)result;
+    (void)capacity;
+}
+
+void test_layout()
+{
+    static_assert(sizeof(cppjson::JsonValue) == (sizeof(cppjson::JsonSize) * 2 + 8), "JsonValue must be packed");
+    static const char json[] = "[[1, [2, 3]], {}, {\"a\": {\"b\": [4]}, \"c\": 5}]";
+    cppjson::JsonReader reader;
+    bool result = reader.parse(json, json + sizeof(json) - 1);
+    assert(result);
+    cppjson::JsonProxy root = reader.root();
+    assert(3 == root.size());
+    assert(!root.next());
+    cppjson::JsonProxy i = root.begin();
+    assert(cppjson::JsonType::Array == i.value().type());
+    i = i.next();
+    assert(cppjson::JsonType::Object == i.value().type());
+    assert(!i.value().begin());
+    i = i.next();
+    cppjson::JsonProxy member = i.value().begin().next();
+    char key[2];
+    member.key().getString(key);
+    assert('c' == key[0]);
+    assert(5 == member.value().getInt64());
+    assert(!i.next());
+    (void)result;
+}
+
+void test_index()
+{
+    std::string json = "{\"long\": \"";
+    json.append(100, 'a');
+    json += "\\\"\", \"escaped\\\\\": [\"\\u00e9\", \"\xC3\xA9\"],\n\t\"n\" :  -1.5e3 }";
+    cppjson::JsonReader reader;
+    reader.setStructuralIndex(true);
+    bool result = reader.parse(json.c_str(), json.c_str() + json.size());
+    assert(result);
+    cppjson::JsonProxy member = reader.root().begin();
+    assert(102 == member.value().size());
+    member = member.next();
+    assert(2 == member.value().size());
+    assert(-1.5e3 == member.next().value().getFloat64());
+
+    json.pop_back();
+    result = reader.parse(json.c_str(), json.c_str() + json.size());
+    assert(!result);
+    (void)result;
+}
+
+void test_utf8()
+{
+    static const char* valid[] = {
+        "[\"0123456789abcdef\xC3\xA9\xE6\x97\xA5\xE6\x9C\xAC\xF0\x9F\x98\x80\"]",
+        "[\"0123456789abcd\xF4\x8F\xBF\xBF\"]",
+    };
+    static const char* invalid[] = {
+        "[\"0123456789abcdef\xC3\"]",
+        "[\"0123456789abcdef\xE0\x80\x80\"]",
+        "[\"0123456789abcdef\xED\xA0\x80\"]",
+        "[\"0123456789abcdef\xF4\x90\x80\x80\"]",
+        "[\"0123456789abcdef\xC0\xAF\"]",
+        "[\"0123456789abcdef\x01\"]",
+    };
+    cppjson::JsonReader reader;
+    for(const char* json: valid) {
+        bool result = reader.parse(json, json + ::strlen(json));
+        assert(result);
+        (void)result;
+    }
+    for(const char* json: invalid) {
+        bool result = reader.parse(json, json + ::strlen(json));
+        assert(!result);
+        (void)result;
+    }
+}
+
+void test_number()
+{
+    static const char json[] = "[0, -0, 1.5e3, -2.5E-3, 9223372036854775807, 9223372036854775808, -9223372036854775809, 18446744073709551616, 123456789012345678901234567890e-20]";
+    for(int decoding = 0; decoding < 2; ++decoding) {
+        cppjson::JsonReader reader;
+        reader.setNumberDecoding(0 != decoding);
+        bool result = reader.parse(json, json + sizeof(json) - 1);
+        assert(result);
+        (void)result;
+        cppjson::JsonProxy element = reader.root().begin();
+        assert(0 == element.value().getInt64());
+        element = element.next();
+        assert(signbit(element.value().getFloat64()));
+        element = element.next();
+        assert(1.5e3 == element.value().getFloat64());
+        element = element.next();
+        assert(-2.5e-3 == element.value().getFloat64());
+        element = element.next();
+        assert(INT64_MAX == element.value().getInt64());
+        assert(!element.value().isUInt64());
+        element = element.next();
+        assert(element.value().isUInt64());
+        assert(0 == element.value().getInt64());
+        assert(9223372036854775808ULL == element.value().getUInt64());
+        element = element.next();
+        assert(element.value().isOverflow());
+        element = element.next();
+        assert(element.value().isOverflow());
+        assert(18446744073709551616.0 == element.value().getFloat64());
+        element = element.next();
+        assert(1234567890.1234567 == element.value().getFloat64());
+        (void)element;
+    }
+
+    // Numbers longer than 128 characters are converted as a whole
+    std::string longs = "[1" + std::string(130, '0') + "e-130, 0." + std::string(126, '0') + "1234, -1" + std::string(200, '0') + "e200, 1" + std::string(200, '0') + ", 0." + std::string(200, '0') + "1e-200]";
+    for(int decoding = 0; decoding < 2; ++decoding) {
+        cppjson::JsonReader reader;
+        reader.setNumberDecoding(0 != decoding);
+        bool result = reader.parse(longs.c_str(), longs.c_str() + longs.size());
+        assert(result);
+        (void)result;
+        cppjson::JsonProxy root = reader.root();
+        assert(1.0 == root.at(0).getFloat64());
+        assert(1.234e-127 == root.at(1).getFloat64());
+        assert(isinf(root.at(2).getFloat64()) && signbit(root.at(2).getFloat64()));
+        assert(1e200 == root.at(3).getFloat64());
+        assert(0.0 == root.at(4).getFloat64() && !signbit(root.at(4).getFloat64()));
+        (void)root;
+    }
+}
+
+void test_find()
+{
+    std::string json = "{\"i\": 0";
+    for(int i = 0; i < 100; ++i) {
+        json += ", \"key" + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    json += ", \"key7\": -1, \"small\": {\"id\": 1, \"i\": 2}}";
+    cppjson::JsonReader reader;
+    bool result = reader.parse(json.c_str(), json.c_str() + json.size());
+    assert(result);
+    (void)result;
+    cppjson::JsonProxy root = reader.root();
+    for(int i = 0; i < 100; ++i) {
+        std::string key = "key" + std::to_string(i);
+        assert(i == root.find(key).getInt64());
+    }
+    assert(!root.find("key"));
+    assert(!root.find("key100"));
+    assert(0 == root.find("i").getInt64());
+    cppjson::JsonProxy small = root.find("small");
+    assert(2 == small.find("i").getInt64());
+    assert(1 == small.find("id").getInt64());
+    assert(!small.find("idx"));
+    assert(small.begin().compareKey("id"));
+    assert(!small.begin().compareKey("i"));
+    assert(!small.begin().find("id"));
+
+    // Lookups from several threads after the tables are built
+    result = reader.parse(json.c_str(), json.c_str() + json.size());
+    assert(result);
+    result = reader.buildTables();
+    assert(result);
+    root = reader.root();
+#ifndef CPPJSON_NO_THREADS
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+        threads.emplace_back([root]() {
+            for(int i = 0; i < 100; ++i) {
+                std::string key = "key" + std::to_string(i);
+                assert(i == root.find(key).getInt64());
+            }
+        });
+    }
+    for(std::thread& thread: threads) {
+        thread.join();
+    }
+#endif // CPPJSON_NO_THREADS
+    assert(7 == root.find("key7").getInt64());
+    (void)small;
+}
+
+void test_at()
+{
+    std::string json = "[[], [1, 2, 3], [";
+    for(int i = 0; i < 1000; ++i) {
+        json += (0 < i ? ", " : "") + std::to_string(i);
+    }
+    json += "], {\"a\": 0}]";
+    cppjson::JsonReader reader;
+    bool result = reader.parse(json.c_str(), json.c_str() + json.size());
+    assert(result);
+    (void)result;
+    cppjson::JsonProxy root = reader.root();
+    assert(4 == root.count());
+    assert(0 == root.at(0).count());
+    assert(!root.at(0).at(0));
+    assert(3 == root.at(1).at(2).getInt64());
+    assert(!root.at(1).at(3));
+    cppjson::JsonProxy large = root.at(2);
+    assert(1000 == large.count());
+    for(int i = 999; 0 <= i; --i) {
+        assert(i == large.at(i).getInt64());
+    }
+    assert(!large.at(1000));
+    assert(1 == root.at(3).count());
+    assert(!root.at(3).at(0));
+    assert(!root.at(4));
+    assert(0 == large.at(0).count());
+
+    // Accesses from several threads after the tables are built
+    result = reader.parse(json.c_str(), json.c_str() + json.size());
+    assert(result);
+    result = reader.buildTables();
+    assert(result);
+    large = reader.root().at(2);
+#ifndef CPPJSON_NO_THREADS
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+        threads.emplace_back([large]() {
+            for(int i = 0; i < 1000; ++i) {
+                assert(i == large.at(i).getInt64());
+            }
+        });
+    }
+    for(std::thread& thread: threads) {
+        thread.join();
+    }
+#endif // CPPJSON_NO_THREADS
+    assert(999 == large.at(999).getInt64());
+}
+
+void test_stream()
+{
+    static const char json[] = "{\"key\": [12345, -1.5e-3, \"a\\\"b\\u00e9\xC3\xA9\", true, null, {}], \"\\\\\": false} ";
+    static const uint64_t size = sizeof(json) - 1;
+    cppjson::JsonReader reader;
+    bool result = reader.parse(json, json + size);
+    assert(result);
+    cppjson::JsonProxy root = reader.root();
+    assert(2 == root.count());
+
+    // Split at every position, in the middle of strings, numbers, escapes and literals
+    cppjson::JsonReader stream;
+    for(uint64_t i = 0; i <= size; ++i) {
+        stream.beginStream();
+        result = stream.feed(json, json + i);
+        assert(result);
+        result = stream.feed(json + i, json + size);
+        assert(result);
+        result = stream.finish();
+        assert(result);
+        cppjson::JsonProxy key = stream.root().find("key");
+        assert(6 == key.count());
+        assert(12345 == key.at(0).getInt64());
+        assert(-1.5e-3 == key.at(1).getFloat64());
+        assert(key.at(2).size() == root.find("key").at(2).size());
+        assert(!stream.root().find("\\\\").getInt64());
+        (void)key;
+    }
+
+    static const char* invalid[] = {"[1", "{\"a\"", "[,1]", "{\"a\": 1,}", "[1] 2", "\"abc", "tru"};
+    for(const char* text: invalid) {
+        stream.beginStream();
+        result = stream.feed(text, text + ::strlen(text)) && stream.finish();
+        assert(!result);
+        result = reader.parse(text, text + ::strlen(text));
+        assert(!result);
+    }
+    (void)root;
+    (void)result;
+}
+
+#ifndef CPPJSON_NO_THREADS
+void test_lines()
+{
+    std::string json;
+    for(int i = 0; i < 20000; ++i) {
+        if(0 == (i % 1000)) {
+            json += "{\"id\": " + std::to_string(i) + ",}\n";
+        } else {
+            json += "{\"id\": " + std::to_string(i) + ", \"name\": \"record\"}\r\n";
+        }
+        if(0 == (i % 3000)) {
+            json += " \t\n";
+        }
+    }
+    json += "[1, 2]";
+    cppjson::JsonLineReader reader(4);
+    for(int trial = 0; trial < 2; ++trial) {
+        bool result = reader.parse(json.c_str(), json.c_str() + json.size());
+        assert(!result);
+        (void)result;
+        assert(20001 == reader.size());
+        for(uint64_t i = 0; i < 20000; ++i) {
+            assert(reader.valid(i) == (0 != (i % 1000)));
+            if(reader.valid(i)) {
+                assert(static_cast<int64_t>(i) == reader.root(i).find("id").getInt64());
+            } else {
+                assert(!reader.root(i));
+            }
+        }
+        assert(2 == reader.root(20000).count());
+    }
+    bool built = reader.buildTables();
+    assert(built);
+    (void)built;
+    assert(1 == reader.root(1).find("id").getInt64());
+    static const char single[] = "true";
+    bool result = reader.parse(single, single + sizeof(single) - 1);
+    assert(result);
+    (void)result;
+    assert(1 == reader.size());
+    assert(cppjson::JsonType::True == reader.root(0).type());
+
+    // Workers which cannot be allocated are dropped, and parse fails without any worker
+    struct Limited
+    {
+        static void* allocate(void* context, size_t size)
+        {
+            int& count = *static_cast<int*>(context);
+            return 0 < count-- ? ::malloc(size) : NULL;
+        }
+        static void deallocate(void*, void* ptr)
+        {
+            ::free(ptr);
+        }
+    };
+    static const int limits[] = {0, 1, 2, 3, 1000};
+    static const uint32_t threads[] = {0, 0, 1, 1, 4};
+    for(int i = 0; i < 5; ++i) {
+        int count = limits[i];
+        cppjson::JsonLineReader limited(4, cppjson::JsonReader::MaxNesting, cppjson::JsonAllocator{Limited::allocate, Limited::deallocate, NULL, &count});
+        assert(threads[i] == limited.threads());
+        result = limited.parse(single, single + sizeof(single) - 1);
+        assert(result == (4 == i));
+    }
+    (void)threads;
+}
+#endif // CPPJSON_NO_THREADS
+
+bool same(cppjson::JsonProxy x, cppjson::JsonProxy y)
+{
+    using namespace cppjson;
+    if(x.type() != y.type()) {
+        return false;
+    }
+    switch(x.type()) {
+    case JsonType::Object:
+    case JsonType::Array: {
+        JsonProxy j = y.begin();
+        for(JsonProxy i = x.begin(); i; i = i.next(), j = j.next()) {
+            if(!j || !same(i, j)) {
+                return false;
+            }
+        }
+        return !j;
+    }
+    case JsonType::KeyValue:
+        return same(x.key(), y.key()) && same(x.value(), y.value());
+    case JsonType::ArrayValue:
+        return same(x.value(), y.value());
+    case JsonType::String: {
+        std::string a(x.size() + 1, '\0');
+        std::string b(y.size() + 1, '\0');
+        x.getString(&a[0]);
+        y.getString(&b[0]);
+        return a == b;
+    }
+    case JsonType::Number:
+        return x.getFloat64() == y.getFloat64();
+    case JsonType::Integer:
+        return x.getInt64() == y.getInt64();
+    default:
+        return true;
+    }
+}
+
+#ifndef CPPJSON_NO_THREADS
+void test_parallel()
+{
+    std::string array = "\n [";
+    std::string object = "{";
+    for(int i = 0; i < 30000; ++i) {
+        std::string n = std::to_string(i);
+        std::string record = "{\"id\": " + n + ", \"name\": \"a, [b] \\\"" + n + "\\\", {c}\", \"values\": [" + n + ".5, -" + n + ", true, null, [], {}]}";
+        array += (0 < i ? ", " : "") + record;
+        object += (0 < i ? ",\n\"" : "\"") + n + "\" : " + record;
+    }
+    array += "] \n";
+    object += "}";
+    assert(cppjson::JsonReader::ParallelThreshold < array.size());
+    assert(cppjson::JsonReader::ParallelThreshold < object.size());
+    for(bool decoding: {false, true}) {
+        for(const std::string* json: {&array, &object}) {
+            cppjson::JsonReader expected;
+            cppjson::JsonReader reader;
+            expected.setNumberDecoding(decoding);
+            reader.setNumberDecoding(decoding);
+            bool result = expected.parse(json->c_str(), json->c_str() + json->size());
+            assert(result);
+            for(uint32_t threads = 1; threads <= 5; ++threads) {
+                result = reader.parseParallel(json->c_str(), json->c_str() + json->size(), threads);
+                assert(result);
+                assert(same(expected.root(), reader.root()));
+                assert(30000 == reader.root().count());
+                cppjson::JsonProxy last = json == &array ? reader.root().at(29999) : reader.root().find("29999");
+                assert(29999 == last.find("id").getInt64());
+                (void)last;
+            }
+            (void)result;
+        }
+    }
+    std::string broken = array;
+    broken[broken.size() / 2] = ']';
+    cppjson::JsonReader reader;
+    bool result = reader.parseParallel(broken.c_str(), broken.c_str() + broken.size(), 4);
+    assert(!result);
+    broken = array;
+    broken.insert(broken.size() / 2, ", ");
+    result = reader.parseParallel(broken.c_str(), broken.c_str() + broken.size(), 4);
+    assert(!result);
+    (void)result;
+}
+#endif // CPPJSON_NO_THREADS
+
+void test_file()
+{
+    static const char path[] = "parse_file.json";
+    std::string json = "[";
+    for(int i = 0; i < 10000; ++i) {
+        json += (0 < i ? ", {\"id\": " : "{\"id\": ") + std::to_string(i) + ", \"name\": \"\\u00e9l\\u00e8ve\"}";
+    }
+    json += "]\n";
+    FILE* f = fopen(path, "wb");
+    assert(NULL != f);
+    fwrite(json.c_str(), 1, json.size(), f);
+    fclose(f);
+
+    cppjson::JsonReader expected;
+    cppjson::JsonReader reader;
+    bool result = expected.parse(json.c_str(), json.c_str() + json.size());
+    assert(result);
+    for(int trial = 0; trial < 2; ++trial) {
+        result = reader.parseFile(path);
+        assert(result);
+        assert(same(expected.root(), reader.root()));
+        assert(9999 == reader.root().at(9999).find("id").getInt64());
+    }
+    result = reader.parseFile("not_found.json");
+    assert(!result);
+    f = fopen(path, "wb");
+    fclose(f);
+    result = reader.parseFile(path);
+    assert(!result);
+    (void)result;
+    remove(path);
+}
+
+void test_cursor()
+{
+    using namespace cppjson;
+    static const char json[] = " {\"skip\": [\"]}\\\"\", {\"a\": [1, {}]}], \"id\" : 12, \"big\": 18446744073709551615,"
+                               " \"pi\": -3.5e0, \"name\": \"a\\\"b\", \"flags\": [true, false, null], \"empty\": {}} ";
+    JsonCursor root = JsonReader::cursor(json, json + sizeof(json) - 1);
+    assert(JsonType::Object == root.type());
+    assert(7 == root.count());
+    assert(JsonType::Array == root.find("skip").type());
+    assert(2 == root.find("skip").size());
+    assert(1 == root.find("skip").at(1).find("a").at(0).getInt64());
+    assert(12 == root.find("id").getInt64());
+    assert(JsonType::Integer == root.find("big").type());
+    assert(18446744073709551615ULL == root.find("big").getUInt64());
+    assert(JsonType::Number == root.find("pi").type());
+    assert(-3.5 == root.find("pi").getFloat64());
+    char name[8];
+    uint64_t size = root.find("name").getString(name);
+    assert(4 == size);
+    assert(0 == strcmp(name, "a\\\"b"));
+    (void)size;
+    JsonCursor flags = root.find("flags");
+    assert(JsonType::True == flags.at(0).type());
+    assert(JsonType::False == flags.at(1).type());
+    assert(JsonType::Null == flags.at(2).type());
+    assert(!flags.at(3));
+    assert(!root.find("empty").begin());
+    assert(0 == root.find("empty").count());
+    assert(!root.find("a"));
+    assert(!root.find("nam"));
+
+    JsonCursor entry = root.begin();
+    assert(JsonType::KeyValue == entry.type());
+    assert(entry.compareKey("skip"));
+    entry = entry.next();
+    assert(entry.compareKey("id"));
+    assert(12 == entry.value().getInt64());
+
+    // Skipped parts are not validated
+    static const char broken[] = "[1, {\"a\" 2}, 3, [4";
+    root = JsonReader::cursor(broken, broken + sizeof(broken) - 1);
+    assert(1 == root.at(0).getInt64());
+    assert(!root.at(1).find("a"));
+    assert(3 == root.at(2).getInt64());
+    assert(JsonType::Array == root.at(3).type());
+    assert(!root.at(4));
+    assert(!JsonReader::cursor(broken, broken));
+
+    // Visited scalars and separators are validated
+    static const char* malformed[] = {"[1x]", "[01]", "[1.]", "[-]", "[1e+]", "[truex]", "[nul]", "[falsey]"};
+    for(const char* str: malformed) {
+        root = JsonReader::cursor(str, str + strlen(str));
+        assert(JsonType::Array == root.type());
+        assert(!root.at(0));
+        assert(0 == root.count());
+    }
+    static const char separator[] = "[1 2]";
+    root = JsonReader::cursor(separator, separator + sizeof(separator) - 1);
+    assert(0 == root.count());
+    assert(!root.at(1));
+    static const char scalars[] = "[0, -0.5e-3, 10E+2, true,false ,null]";
+    root = JsonReader::cursor(scalars, scalars + sizeof(scalars) - 1);
+    assert(6 == root.count());
+    assert(JsonType::Integer == root.at(0).type());
+    assert(JsonType::Number == root.at(1).type());
+    assert(JsonType::Number == root.at(2).type());
+    assert(JsonType::Null == root.at(5).type());
+    static const char single[] = "7";
+    assert(JsonType::Integer == JsonReader::cursor(single, single + 1).type());
+    (void)name;
+    (void)flags;
+    (void)single;
+}
+
+void test_query()
+{
+    using namespace cppjson;
+    JsonQuery query;
+    uint32_t id = query.add("/user/id");
+    uint32_t ts = query.add("events.*.ts");
+    uint32_t second = query.add("/events/1");
+    uint32_t slash = query.add("/a~1b/~0c");
+    uint32_t tags = query.add("/user/tags");
+    uint32_t tag = query.add("/user/tags/1");
+    assert(6 == query.size());
+    uint32_t same = query.add("user.id");
+    assert(id == same);
+    uint32_t invalid = query.add("/a~2");
+    assert(JsonQuery::Invalid == invalid);
+
+    static const char json[] = "{\"skip\": [{\"user\": {\"id\": -1}}, \"}\"], \"user\": {\"name\": \"x\", \"id\": 7, \"tags\": [\"p\", \"q\"]},"
+                               " \"events\": [{\"ts\": 1}, {\"ts\": 2.5, \"x\": [1, 2]}, {\"other\": 3}, {\"ts\": \"3\"}], \"a/b\": {\"~c\": true}}";
+    JsonReader reader;
+    for(int trial = 0; trial < 2; ++trial) {
+        bool result = reader.parse(json, json + sizeof(json) - 1, query);
+        assert(result);
+        (void)result;
+        assert(8 == reader.matches());
+        assert(id == reader.matchPath(0));
+        assert(7 == reader.match(0).getInt64());
+        assert(tags == reader.matchPath(1));
+        assert(2 == reader.match(1).count());
+        assert(tag == reader.matchPath(2));
+        assert(JsonType::String == reader.match(2).type());
+        assert(ts == reader.matchPath(3));
+        assert(1 == reader.match(3).getInt64());
+        assert(second == reader.matchPath(4));
+        assert(2 == reader.match(4).count());
+        assert(ts == reader.matchPath(5));
+        assert(2.5 == reader.match(5).getFloat64());
+        assert(ts == reader.matchPath(6));
+        assert(JsonType::String == reader.match(6).type());
+        assert(slash == reader.matchPath(7));
+        assert(JsonType::True == reader.match(7).type());
+    }
+
+    // The root
+    JsonQuery all;
+    uint32_t root = all.add("");
+    assert(0 == root);
+    bool result = reader.parse(json, json + sizeof(json) - 1, all);
+    assert(result);
+    assert(1 == reader.matches());
+    assert(4 == reader.match(0).count());
+
+    static const char broken[] = "{\"user\": {\"id\": 7,}}";
+    result = reader.parse(broken, broken + sizeof(broken) - 1, query);
+    assert(!result);
+    result = reader.parse(json, json + sizeof(json) - 2, query);
+    assert(!result);
+
+    // Pruned members are validated as parse does
+    JsonQuery a;
+    a.add("/a");
+    static const char* pruned[] = {
+        "{\"skip\": [1 2], \"a\": 1}",
+        "{\"skip\": {\"x\" 1}, \"a\": 1}",
+        "{\"skip\": \"\\q\", \"a\": 1}",
+        "{\"skip\": 01, \"a\": 1}",
+        "{\"\\q\": 1, \"a\": 1}",
+    };
+    for(const char* str: pruned) {
+        result = reader.parse(str, str + ::strlen(str));
+        assert(!result);
+        result = reader.parse(str, str + ::strlen(str), a);
+        assert(!result);
+    }
+    static const char valid[] = "{\"skip\": [1, {\"x\": \"\\u00e9\"}], \"a\": 1}";
+    result = reader.parse(valid, valid + sizeof(valid) - 1, a);
+    assert(result);
+    assert(1 == reader.matches() && 1 == reader.match(0).getInt64());
+    (void)id;
+    (void)ts;
+    (void)second;
+    (void)slash;
+    (void)tags;
+    (void)tag;
+    (void)same;
+    (void)invalid;
+    (void)root;
+    (void)result;
+}
+
+void test_projection()
+{
+    using namespace cppjson;
+    JsonQuery projection;
+    projection.add("/id");
+    projection.add("/user/name");
+    projection.add("/items/*/sku");
+    projection.add("/tags/1");
+
+    static const char json[] = "{\"skip\": {\"id\": [1, \"x\"]}, \"id\": 7, \"user\": {\"age\": 3, \"name\": {\"first\": \"a\"}},"
+                               " \"items\": [{\"sku\": \"p\", \"n\": 1}, 5, {\"n\": 2}], \"tags\": [\"a\", \"b\", \"c\"], \"name\": 1}";
+    JsonReader reader;
+    reader.setProjection(&projection);
+    for(bool indexing: {false, true}) {
+        reader.setStructuralIndex(indexing);
+        bool result = reader.parse(json, json + sizeof(json) - 1);
+        assert(result);
+        (void)result;
+        JsonProxy root = reader.root();
+        assert(4 == root.count());
+        assert(7 == root.find("id").getInt64());
+        assert(!root.find("skip"));
+        assert(!root.find("name"));
+        JsonProxy user = root.find("user");
+        assert(1 == user.count());
+        assert(1 == user.find("name").count());
+        JsonProxy items = root.find("items");
+        assert(2 == items.count());
+        assert(1 == items.at(0).count());
+        char str[2];
+        items.at(0).find("sku").getString(str);
+        assert(0 == strcmp(str, "p"));
+        assert(0 == items.at(1).count());
+        JsonProxy tags = root.find("tags");
+        assert(1 == tags.count());
+        tags.at(0).getString(str);
+        assert(0 == strcmp(str, "b"));
+        (void)user;
+    }
+
+    // The skipped parts are validated
+    static const char invalid[] = "{\"skip\": {\"id\": [1, \"x\" 2]}, \"id\": 7}";
+    bool result = reader.parse(invalid, invalid + sizeof(invalid) - 1);
+    assert(!result);
+    static const char escape[] = "{\"skip\": \"\\x\", \"id\": 7}";
+    result = reader.parse(escape, escape + sizeof(escape) - 1);
+    assert(!result);
+    reader.setProjection(CPPJSON_NULL);
+    result = reader.parse(json, json + sizeof(json) - 1);
+    assert(result);
+    assert(6 == reader.root().count());
+    (void)result;
+}
+
+#ifndef CPPJSON_NO_BIND
+namespace bind
+{
+struct Point
+{
+    double x;
+    double y;
+};
+CPPJSON_BIND(Point, x, y)
+
+struct User
+{
+    int64_t id;
+    std::string name;
+    std::string_view raw;
+    std::vector<Point> points;
+    std::optional<int32_t> age;
+    std::optional<std::string> nickname;
+    bool active;
+    uint8_t level;
+    float score;
+};
+CPPJSON_BIND(User, id, name, raw, points, age, nickname, active, level, score)
+} // namespace bind
+
+void test_bind()
+{
+    static const char json[] = "{\"id\": 5, \"unknown\": {\"id\": [1, \"x\"]}, \"name\": \"bob\", \"raw\": \"a\\nb\", \"points\": [{\"x\": 1, \"y\": -2.5e1}, {\"y\": 3}],"
+                               " \"age\": null, \"nickname\": \"b\", \"active\": true, \"level\": 200, \"score\": 0.5}";
+    cppjson::JsonReader reader;
+    bind::User user{};
+    user.age = 3;
+    bool result = reader.bind(json, json + sizeof(json) - 1, user);
+    assert(result);
+    assert(5 == user.id);
+    assert("bob" == user.name);
+    assert("a\\nb" == user.raw);
+    assert(2 == user.points.size());
+    assert(1.0 == user.points[0].x);
+    assert(-25.0 == user.points[0].y);
+    assert(0.0 == user.points[1].x);
+    assert(3.0 == user.points[1].y);
+    assert(!user.age);
+    assert("b" == user.nickname.value());
+    assert(user.active);
+    assert(200 == user.level);
+    assert(0.5f == user.score);
+
+    std::vector<int16_t> values;
+    static const char array[] = " [1, -2, 32767] ";
+    result = reader.bind(array, array + sizeof(array) - 1, values);
+    assert(result);
+    assert(3 == values.size() && -2 == values[1] && 32767 == values[2]);
+
+    // std::string decodes escapes, while std::string_view keeps them
+    static const char escaped[] = "{\"name\": \"O\\\"Brien\", \"raw\": \"a\\nb\", \"nickname\": \"a\\nb\\u00e9\\ud83d\\ude00\"}";
+    result = reader.bind(escaped, escaped + sizeof(escaped) - 1, user);
+    assert(result);
+    assert("O\"Brien" == user.name);
+    assert("a\\nb" == user.raw);
+    assert("a\nb\xC3\xA9\xF0\x9F\x98\x80" == user.nickname.value());
+
+    // Values which do not fit the types, and malformed documents
+    static const char range[] = "{\"level\": 256}";
+    result = reader.bind(range, range + sizeof(range) - 1, user);
+    assert(!result);
+    static const char fraction[] = "{\"id\": 1.5}";
+    result = reader.bind(fraction, fraction + sizeof(fraction) - 1, user);
+    assert(!result);
+    static const char type[] = "{\"name\": 1}";
+    result = reader.bind(type, type + sizeof(type) - 1, user);
+    assert(!result);
+    static const char skipped[] = "{\"unknown\": [1 2], \"id\": 1}";
+    result = reader.bind(skipped, skipped + sizeof(skipped) - 1, user);
+    assert(!result);
+    static const char trailing[] = "[1, 2] 3";
+    result = reader.bind(trailing, trailing + sizeof(trailing) - 1, values);
+    assert(!result);
+    (void)result;
+}
+#endif // CPPJSON_NO_BIND
+
+void test_writer()
+{
+    using namespace cppjson;
+    JsonWriter writer;
+    writer.beginObject();
+    writer.key("id");
+    writer.writeInt64(INT64_MIN);
+    writer.key("n");
+    writer.writeUInt64(UINT64_MAX);
+    writer.key("f");
+    writer.beginArray();
+    writer.writeFloat64(0.1);
+    writer.writeFloat64(1.0e300);
+    writer.writeFloat64(-2.5);
+    writer.writeFloat64(NAN);
+    writer.endArray();
+    writer.key("s\"");
+    writer.writeString("a \"quoted\" path\\\n\t\x01 with a long tail \xE3\x81\x82");
+    writer.key("e");
+    writer.beginArray();
+    writer.beginObject();
+    writer.endObject();
+    writer.writeBool(true);
+    writer.writeNull();
+    writer.endArray();
+    writer.endObject();
+    static const char expected[] = "{\"id\":-9223372036854775808,\"n\":18446744073709551615,\"f\":[0.1,1e+300,-2.5,null],"
+                                   "\"s\\\"\":\"a \\\"quoted\\\" path\\\\\\n\\t\\u0001 with a long tail \xE3\x81\x82\",\"e\":[{},true,null]}";
+    assert(std::string_view(expected) == std::string_view(writer.data(), writer.size()));
+    (void)expected;
+
+    // Written numbers are read back as the same values
+    JsonReader reader;
+    bool result = reader.parse(writer.data(), writer.data() + writer.size());
+    assert(result);
+    (void)result;
+    assert(0.1 == reader.root().find("f").at(0).getFloat64());
+    assert(1.0e300 == reader.root().find("f").at(1).getFloat64());
+
+    // Subtrees are copied from the document
+    static const char json[] = "{\"a\": [1, {\"b\" : \"x\\u0041\"}, 2.50], \"c\": \"\\n\", \"d\": false}";
+    result = reader.parse(json, json + sizeof(json) - 1);
+    assert(result);
+    writer.clear();
+    writer.beginArray();
+    writer.write(reader.root().find("a"));
+    writer.write(reader.root().find("c"));
+    writer.write(reader.root().find("a").at(2));
+    writer.endArray();
+    assert(std::string_view("[[1, {\"b\" : \"x\\u0041\"}, 2.50],\"\\n\",2.50]") == std::string_view(writer.data(), writer.size()));
+    writer.clear();
+    writer.beginObject();
+    writer.write(reader.root().begin().next());
+    writer.endObject();
+    assert(std::string_view("{\"c\":\"\\n\"}") == std::string_view(writer.data(), writer.size()));
+
+    // Projected documents are written without the dropped children
+    JsonQuery projection;
+    projection.add("/a/1");
+    projection.add("/d");
+    reader.setProjection(&projection);
+    result = reader.parse(json, json + sizeof(json) - 1);
+    assert(result);
+    writer.clear();
+    writer.write(reader.root());
+    assert(std::string_view("{\"a\":[{\"b\":\"x\\u0041\"}],\"d\":false}") == std::string_view(writer.data(), writer.size()));
+}
+
+void test_format()
+{
+    using namespace cppjson;
+    static const char json[] = " {\"a b\" : [ 1, 2.5e3 ,\n\t\"x \\\" y\"], \"o\": { }, \"e\": [ ], \"n\": {\"t\": true} }\n";
+    static const char minified[] = "{\"a b\":[1,2.5e3,\"x \\\" y\"],\"o\":{},\"e\":[],\"n\":{\"t\":true}}";
+    JsonWriter writer;
+    writer.minify(json, json + sizeof(json) - 1);
+    assert(std::string_view(minified) == std::string_view(writer.data(), writer.size()));
+
+    writer.clear();
+    writer.prettify(json, json + sizeof(json) - 1, 2);
+    static const char pretty[] = "{\n  \"a b\": [\n    1,\n    2.5e3,\n    \"x \\\" y\"\n  ],\n  \"o\": {},\n  \"e\": [],\n  \"n\": {\n    \"t\": true\n  }\n}";
+    assert(std::string_view(pretty) == std::string_view(writer.data(), writer.size()));
+    (void)pretty;
+
+    // Prettified documents are minified back, across blocks of 64 bytes
+    std::string large;
+    for(uint32_t i = 0; i < 64; ++i) {
+        large += 0 == i ? "[" : ",";
+        large += json;
+    }
+    large += "]";
+    writer.clear();
+    writer.prettify(large.data(), large.data() + large.size());
+    std::string expanded(writer.data(), writer.size());
+    writer.clear();
+    writer.minify(expanded.data(), expanded.data() + expanded.size());
+    std::string expected;
+    for(uint32_t i = 0; i < 64; ++i) {
+        expected += 0 == i ? "[" : ",";
+        expected += minified;
+    }
+    expected += "]";
+    assert(expected == std::string_view(writer.data(), writer.size()));
+    uint64_t size = JsonWriter::minifyInPlace(large.data(), large.data() + large.size());
+    assert(expected == std::string_view(large.data(), size));
+    (void)size;
+}
+
+void test_saved_index()
+{
+    using namespace cppjson;
+    static const char path[] = "saved_index.json";
+    static const char index_path[] = "saved_index.idx";
+    std::string json = "{";
+    for(int i = 0; i < 100; ++i) {
+        json += (0 < i ? ", \"k" : "\"k") + std::to_string(i) + "\": [" + std::to_string(i) + ".5, \"v\", " + std::to_string(i) + "]";
+    }
+    json += ", \"list\": [";
+    for(int i = 0; i < 100; ++i) {
+        json += (0 < i ? ", " : "") + std::to_string(i * 3);
+    }
+    json += "]}";
+    FILE* f = fopen(path, "wb");
+    assert(NULL != f);
+    fwrite(json.c_str(), 1, json.size(), f);
+    fclose(f);
+
+    // Tables built before saving are dropped from the file, and built again after loading
+    JsonReader expected;
+    expected.setNumberDecoding(true);
+    bool result = expected.parse(json.c_str(), json.c_str() + json.size());
+    assert(result);
+    result = expected.buildTables();
+    assert(result);
+#ifndef CPPJSON_NO_THREADS
+    // Saving does not modify the reader, while others look up
+    JsonProxy root = expected.root();
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 2; ++t) {
+        threads.emplace_back([root]() {
+            for(int i = 0; i < 100; ++i) {
+                assert(3 * i == root.find("list").at(i).getInt64());
+            }
+        });
+    }
+    result = expected.saveIndex(index_path);
+    for(std::thread& thread: threads) {
+        thread.join();
+    }
+    assert(result);
+#endif // CPPJSON_NO_THREADS
+    assert(150 == expected.root().find("list").at(50).getInt64());
+    result = expected.saveIndex(index_path);
+    assert(result);
+
+    JsonReader reader;
+    for(int trial = 0; trial < 2; ++trial) {
+        result = 0 == trial ? reader.loadIndex(index_path, json.c_str(), json.c_str() + json.size()) : reader.loadFile(path, index_path);
+        assert(result);
+        assert(same(expected.root(), reader.root()));
+        assert(0.5 == reader.root().find("k0").at(0).getFloat64());
+        assert(99 == reader.root().find("k99").at(2).getInt64());
+        assert(297 == reader.root().find("list").at(99).getInt64());
+    }
+
+    // Elements are not loaded for other documents or broken files
+    for(size_t i = 0; i < json.size(); i += 7) {
+        std::string other = json;
+        other[i] = '"' == other[i] ? '\'' : '"';
+        result = reader.loadIndex(index_path, other.c_str(), other.c_str() + other.size());
+        assert(!result);
+    }
+    result = reader.loadIndex(index_path, json.c_str(), json.c_str() + json.size() - 1);
+    assert(!result);
+    result = reader.loadIndex(path, json.c_str(), json.c_str() + json.size());
+    assert(!result);
+    result = reader.loadIndex("not_found.idx", json.c_str(), json.c_str() + json.size());
+    assert(!result);
+
+    // Broken elements are rejected, or refer to inside of the document and the elements
+    f = fopen(index_path, "rb");
+    assert(NULL != f);
+    std::string saved;
+    for(int c = fgetc(f); EOF != c; c = fgetc(f)) {
+        saved.push_back(static_cast<char>(c));
+    }
+    fclose(f);
+    static const char broken_path[] = "saved_index_broken.idx";
+    for(size_t i = 0; i < saved.size(); i += 20) {
+        for(char c: {'\xFF', '\x01'}) {
+            std::string broken = saved;
+            broken[i] = c;
+            broken.append(0 == i % 400 ? 1 : 0, '\0');
+            f = fopen(broken_path, "wb");
+            assert(NULL != f);
+            fwrite(broken.c_str(), 1, broken.size(), f);
+            fclose(f);
+            result = reader.loadIndex(broken_path, json.c_str(), json.c_str() + json.size());
+            if(result) {
+                same(expected.root(), reader.root());
+                result = reader.buildTables();
+                assert(result);
+            }
+        }
+    }
+    remove(broken_path);
+
+    // The reader parses again after loading
+    result = reader.loadIndex(index_path, json.c_str(), json.c_str() + json.size());
+    assert(result);
+    result = reader.reserve(16) && reader.parse("[1]", "[1]" + 3);
+    assert(result);
+    assert(1 == reader.root().at(0).getInt64());
+    (void)result;
+    remove(index_path);
+    remove(path);
+}
+
+void test_nesting()
+{
+    using namespace cppjson;
+    // Nesting far beyond the call stack is bounded by the stack budget only
+    std::string json(10000, '[');
+    json += "{\"a\": [1, {\"b\": 2}]}";
+    json += std::string(10000, ']');
+    JsonReader reader;
+    for(bool indexing: {false, true}) {
+        reader.setStructuralIndex(indexing);
+        bool result = reader.parse(json.c_str(), json.c_str() + json.size());
+        assert(result);
+        (void)result;
+        JsonProxy value = reader.root();
+        for(int i = 0; i < 10000; ++i) {
+            assert(JsonType::Array == value.type());
+            assert(1 == value.count());
+            value = value.at(0);
+        }
+        assert(2 == value.find("a").at(1).find("b").getInt64());
+    }
+
+    // Skipped subtrees of projections are not limited by the nesting of calls
+    JsonQuery projection;
+    projection.add("/id");
+    std::string skipped = "{\"deep\": " + json + ", \"id\": 3}";
+    reader.setProjection(&projection);
+    bool result = reader.parse(skipped.c_str(), skipped.c_str() + skipped.size());
+    assert(result);
+    assert(3 == reader.root().find("id").getInt64());
+    reader.setProjection(CPPJSON_NULL);
+
+    reader.setStackBudget(1024);
+    result = reader.parse(json.c_str(), json.c_str() + json.size());
+    assert(!result);
+
+    // Streams accept the same nesting as parse
+    JsonReader stream;
+    stream.beginStream();
+    for(size_t i = 0; i < json.size(); i += 100) {
+        result = stream.feed(json.c_str() + i, json.c_str() + (json.size() < i + 100 ? json.size() : i + 100));
+        assert(result);
+    }
+    result = stream.finish();
+    assert(result);
+    JsonProxy value = stream.root();
+    for(int i = 0; i < 10000; ++i) {
+        assert(1 == value.count());
+        value = value.at(0);
+    }
+    assert(2 == value.find("a").at(1).find("b").getInt64());
+    stream.setStackBudget(1024);
+    for(size_t depth: {85, 86, 87}) {
+        std::string nested = std::string(depth, '[') + std::string(depth, ']');
+        bool parsed = reader.parse(nested.c_str(), nested.c_str() + nested.size());
+        assert(parsed == (depth <= 86));
+        stream.beginStream();
+        result = stream.feed(nested.c_str(), nested.c_str() + nested.size()) && stream.finish();
+        assert(parsed == result);
+        (void)parsed;
+    }
+    (void)result;
+}
+
+struct Counter
+{
+    uint64_t allocations_;
+    uint64_t deallocations_;
+};
+
+void* count_allocate(void* context, size_t size)
+{
+    ++reinterpret_cast<Counter*>(context)->allocations_;
+    return malloc(size);
+}
+
+void count_deallocate(void* context, void* ptr)
+{
+    if(NULL != ptr) {
+        ++reinterpret_cast<Counter*>(context)->deallocations_;
+    }
+    free(ptr);
+}
+
+void test_allocator()
+{
+    using namespace cppjson;
+    std::string json = "[";
+    for(int i = 0; i < 1000; ++i) {
+        json += (0 < i ? ", {\"id\": " : "{\"id\": ") + std::to_string(i) + ", \"name\": \"n\"}";
+    }
+    json += "]";
+
+    // Each round frees everything at once, and runs in one merged chunk after the first reset
+    JsonArena arena(1024);
+    uint64_t capacity = 0;
+    for(int round = 0; round < 3; ++round) {
+        {
+            JsonReader reader(JsonReader::MaxNesting, arena.allocator());
+            reader.setNumberDecoding(true);
+            bool result = reader.parse(json.c_str(), json.c_str() + json.size());
+            assert(result);
+            (void)result;
+            assert(999 == reader.root().at(999).find("id").getInt64());
+        }
+        assert(0 < arena.size());
+        assert(0 == round || capacity == arena.capacity());
+        bool result = arena.reset();
+        assert(result);
+        (void)result;
+        assert(0 == arena.size());
+        capacity = arena.capacity();
+    }
+    void* first = arena.allocate(10);
+    assert(0 == (reinterpret_cast<uintptr_t>(first) % JsonArena::Align));
+    void* grown = arena.reallocate(first, 10, 100);
+    assert(first == grown);
+    void* second = arena.allocate(10);
+    assert(second != first);
+    void* shrunk = arena.reallocate(second, 10, 5);
+    assert(second == shrunk);
+    (void)capacity;
+    (void)grown;
+    (void)shrunk;
+    arena.deallocate(second);
+    assert(JsonArena::Align * 7 == arena.size());
+    arena.release();
+    assert(0 == arena.capacity());
+
+    // Blocks given back are reused by the next reader
+    JsonPool pool;
+    uint64_t cached = 0;
+    for(int round = 0; round < 3; ++round) {
+        {
+            JsonReader reader(JsonReader::MaxNesting, pool.allocator());
+            bool result = reader.parse(json.c_str(), json.c_str() + json.size());
+            assert(result);
+            (void)result;
+            assert(1000 == reader.root().count());
+        }
+        assert(0 < pool.cached());
+        assert(0 == round || cached == pool.cached());
+        cached = pool.cached();
+    }
+    void* block = pool.allocate(100);
+    assert(0 == (reinterpret_cast<uintptr_t>(block) % JsonPool::Align));
+    void* resized = pool.reallocate(block, 100, 110);
+    assert(block == resized);
+    pool.deallocate(resized);
+    void* reused = pool.allocate(90);
+    assert(block == reused);
+    pool.deallocate(reused);
+    assert(cached <= pool.cached());
+    (void)cached;
+    pool.trim();
+    assert(0 == pool.cached());
+
+    // The context is passed to each function
+    Counter counter = {0, 0};
+    {
+        JsonAllocator allocator = {count_allocate, count_deallocate, NULL, &counter};
+        JsonWriter writer(allocator);
+        writer.beginArray();
+        for(int i = 0; i < 1000; ++i) {
+            writer.writeInt64(i);
+        }
+        writer.endArray();
+        JsonQuery query(allocator);
+        query.add("/a/b");
+    }
+    assert(0 < counter.allocations_);
+    assert(counter.allocations_ == counter.deallocations_);
+}
+
+#ifndef CPPJSON_NO_THREADS
+void test_reader_pool()
+{
+    using namespace cppjson;
+    std::string small = "[1, 2, 3]";
+    std::string large = "[";
+    for(int i = 0; i < 100000; ++i) {
+        large += (0 < i ? ", " : "") + std::to_string(i);
+    }
+    large += "]";
+
+    // A released reader keeps its buffers, unless those exceed the high-water mark
+    JsonReaderPool pool(2, 64 * 1024);
+    JsonReader* reader = pool.acquire();
+    assert(NULL != reader);
+    bool result = reader->parse(small.c_str(), small.c_str() + small.size());
+    assert(result);
+    (void)result;
+    pool.release(reader);
+    JsonReader* reused = pool.acquire();
+    assert(reader == reused);
+    reader = reused;
+    uint64_t capacity = reader->capacity();
+    assert(0 < capacity);
+    (void)capacity;
+    result = reader->parse(large.c_str(), large.c_str() + large.size());
+    assert(result);
+    assert(64 * 1024 < reader->memory());
+    pool.release(reader);
+    JsonReaderPool::Statistics statistics = pool.statistics();
+    assert(2 == statistics.acquires_);
+    assert(1 == statistics.reuses_);
+    assert(1 == statistics.shrinks_);
+    assert(1 == statistics.idle_);
+    assert(statistics.memory_ <= 64 * 1024 * 9);
+    reader = pool.acquire();
+    assert(!reader->root());
+
+    // Settings of the previous borrower are not carried over
+    static const char nested[] = "[[[1]]]";
+    reader->setStackBudget(12);
+    reader->setNumberDecoding(true);
+    result = reader->parse(nested, nested + sizeof(nested) - 1);
+    assert(!result);
+    pool.release(reader);
+    reader = pool.acquire();
+    result = reader->parse(nested, nested + sizeof(nested) - 1);
+    assert(result);
+    pool.release(reader);
+
+    // Readers beyond the maximum of idle readers are destroyed
+    JsonReader* readers[3];
+    for(int i = 0; i < 3; ++i) {
+        readers[i] = pool.acquire();
+        assert(NULL != readers[i]);
+    }
+    for(int i = 0; i < 3; ++i) {
+        pool.release(readers[i]);
+    }
+    statistics = pool.statistics();
+    assert(2 == statistics.idle_);
+    assert(1 == statistics.destroys_);
+
+    // Threads share the pool
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 4; ++i) {
+        threads.emplace_back([&pool, &small]() {
+            for(int j = 0; j < 1000; ++j) {
+                JsonReader* reader = pool.acquire();
+                bool result = reader->parse(small.c_str(), small.c_str() + small.size());
+                assert(result);
+                (void)result;
+                assert(3 == reader->root().count());
+                pool.release(reader);
+            }
+        });
+    }
+    for(std::thread& thread: threads) {
+        thread.join();
+    }
+    statistics = pool.statistics();
+    assert(4007 == statistics.acquires_);
+    assert(statistics.idle_ <= 2);
+    pool.trim();
+    assert(0 == pool.statistics().idle_);
+}
+#endif // CPPJSON_NO_THREADS
+
+void test_validate()
+{
+    using namespace cppjson;
+    struct Case
+    {
+        const char* json_;
+        JsonError error_;
+        uint64_t offset_;
+    };
+    static const Case cases[] = {
+        {"{\"a\": [1, -2.5e3, true, false, null, \"\\u00e9\\n\"], \"b\": {}}", JsonError::None, 0},
+        {"  \"\xC3\xA9\"  ", JsonError::None, 0},
+        {"", JsonError::UnexpectedEnd, 0},
+        {"[1, 2", JsonError::UnexpectedEnd, 5},
+        {"{\"a\" 1}", JsonError::UnexpectedCharacter, 5},
+        {"[1, 2,]", JsonError::UnexpectedCharacter, 6},
+        {"[1] x", JsonError::UnexpectedCharacter, 4},
+        {"\"abcdefghijklmnopqrstuvwxyz\x01\"", JsonError::InvalidString, 27},
+        {"\"abcdefghijklmnopqrstuvwxyz\\x\"", JsonError::InvalidEscape, 27},
+        {"\"ab\\u12G4\"", JsonError::InvalidEscape, 3},
+        {"\"abcdefghijklmnopqrstuvwxyz\xC3\x28\"", JsonError::InvalidUtf8, 27},
+        {"\"abc", JsonError::UnexpectedEnd, 4},
+        {"[01]", JsonError::InvalidNumber, 1},
+        {"[1.e5]", JsonError::InvalidNumber, 1},
+        {"[tru]", JsonError::InvalidLiteral, 1},
+    };
+    JsonReader reader;
+    for(int indexing = 0; indexing < 2; ++indexing) {
+        reader.setStructuralIndex(0 != indexing);
+        for(const Case& c: cases) {
+            const char* end = c.json_ + strlen(c.json_);
+            JsonStatus status = reader.validate(c.json_, end);
+            assert(c.error_ == status.error_);
+            assert(c.offset_ == status.offset_);
+            bool result = reader.parse(c.json_, end);
+            assert(static_cast<bool>(status) == result);
+            (void)status;
+            (void)result;
+        }
+    }
+
+    // Nesting is limited by the stack budget
+    std::string nested(1000, '[');
+    nested += std::string(1000, ']');
+    JsonStatus status = reader.validate(nested.c_str(), nested.c_str() + nested.size());
+    assert(status);
+    reader.setStackBudget(100);
+    status = reader.validate(nested.c_str(), nested.c_str() + nested.size());
+    assert(JsonError::TooDeep == status.error_);
+    bool result = reader.parse(nested.c_str(), nested.c_str() + nested.size());
+    assert(result == static_cast<bool>(status));
+    (void)status;
+    (void)result;
+}
+
+struct Events
+{
+    bool on_object_begin()
+    {
+        out_ += "{";
+        return true;
+    }
+    bool on_object_end(uint64_t members)
+    {
+        out_ += "}" + std::to_string(members);
+        return true;
+    }
+    bool on_array_begin()
+    {
+        out_ += "[";
+        return true;
+    }
+    bool on_array_end(uint64_t elements)
+    {
+        out_ += "]" + std::to_string(elements);
+        return true;
+    }
+    bool on_key(std::string_view key)
+    {
+        out_ += "k:" + std::string(key) + " ";
+        return true;
+    }
+    bool on_string(std::string_view value)
+    {
+        out_ += "s:" + std::string(value) + " ";
+        return value != "stop";
+    }
+    bool on_int(int64_t value)
+    {
+        out_ += "i:" + std::to_string(value) + " ";
+        return true;
+    }
+    bool on_uint(uint64_t value)
+    {
+        out_ += "u:" + std::to_string(value) + " ";
+        return true;
+    }
+    bool on_double(double value)
+    {
+        out_ += "d:" + std::to_string(value) + " ";
+        return true;
+    }
+    bool on_bool(bool value)
+    {
+        out_ += value ? "true " : "false ";
+        return true;
+    }
+    bool on_null()
+    {
+        out_ += "null ";
+        return true;
+    }
+    std::string out_;
+};
+
+void test_events()
+{
+    using namespace cppjson;
+    static const char json[] = " {\"a\": [1, -2, 18446744073709551615, 1.5, 1e400, true, false, null], \"b\\n\": {\"c\": \"x\\ty\"}, \"d\": {}, \"e\": []} ";
+    static const char expected[] = "{k:a [i:1 i:-2 u:18446744073709551615 d:1.500000 d:inf true false null ]8k:b\\n {k:c s:x\\ty }1k:d {}0k:e []0}4";
+    JsonReader reader;
+    for(int indexing = 0; indexing < 2; ++indexing) {
+        reader.setStructuralIndex(0 != indexing);
+        Events events;
+        bool result = reader.parse(json, json + sizeof(json) - 1, events);
+        assert(result);
+        (void)result;
+        assert(expected == events.out_);
+        assert(!reader.root());
+    }
+
+    // Malformed documents and handlers returning false stop the events
+    static const char* invalids[] = {"[1, 2", "[1 2]", "{\"a\" 1}", "[1] 2", "[\"stop\", 1]", ""};
+    for(const char* invalid: invalids) {
+        Events events;
+        bool result = reader.parse(invalid, invalid + strlen(invalid), events);
+        assert(!result);
+        (void)result;
+    }
+    Events events;
+    static const char stop[] = "[\"stop\", 1]";
+    reader.parse(stop, stop + sizeof(stop) - 1, events);
+    assert("[s:stop " == events.out_);
+
+    // Nesting is limited by the stack budget
+    std::string nested(1000, '[');
+    nested += std::string(1000, ']');
+    bool result = reader.parse(nested.c_str(), nested.c_str() + nested.size(), events);
+    assert(result);
+    reader.setStackBudget(100);
+    result = reader.parse(nested.c_str(), nested.c_str() + nested.size(), events);
+    assert(!result);
+
+    // Queries are not handlers
+    JsonQuery query;
+    query.add("/a/0");
+    result = reader.parse(json, json + sizeof(json) - 1, query);
+    assert(result);
+    assert(1 == reader.matches());
+    (void)expected;
+    (void)result;
+}
+
+void test_unescape()
+{
+    using namespace cppjson;
+    static const char json[] = "[\"plain text which is longer than sixteen bytes\", \"a\\nb\", "
+                               "\"\\u00e9\\u3042\\ud83d\\ude00 \\ud800 \\\"\\\\\\/\\b\\f\\r\\t and a long tail without escapes\"]";
+    JsonReader reader;
+    for(int indexing = 0; indexing < 2; ++indexing) {
+        reader.setStructuralIndex(0 != indexing);
+        bool result = reader.parse(json, json + sizeof(json) - 1);
+        assert(result);
+        (void)result;
+        JsonProxy plain = reader.root().at(0);
+        assert(!plain.isEscaped());
+        assert("plain text which is longer than sixteen bytes" == plain.getStringView());
+        assert(plain.getStringView().data() == json + 2);
+
+        char str[128];
+        JsonProxy newline = reader.root().at(1);
+        assert(newline.isEscaped());
+        assert("a\\nb" == newline.getStringView());
+        uint64_t size = newline.getString(str, sizeof(str));
+        assert(3 == size);
+        assert(0 == strcmp("a\nb", str));
+
+        static const char expected[] = "\xC3\xA9\xE3\x81\x82\xF0\x9F\x98\x80 \xEF\xBF\xBD \"\\/\b\f\r\t and a long tail without escapes";
+        JsonProxy mixed = reader.root().at(2);
+        assert(mixed.isEscaped());
+        size = mixed.getString(str, sizeof(str));
+        assert(sizeof(expected) - 1 == size);
+        assert(0 == memcmp(expected, str, sizeof(expected)));
+
+        // The result is truncated, and the size tells the capacity to decode all
+        for(uint64_t capacity = 0; capacity <= size; ++capacity) {
+            memset(str, 'x', sizeof(str));
+            uint64_t truncated = mixed.getString(0 < capacity ? str : NULL, capacity);
+            assert(size == truncated);
+            (void)truncated;
+            if(0 < capacity) {
+                assert(0 == memcmp(expected, str, capacity - 1));
+                assert('\0' == str[capacity - 1]);
+                assert('x' == str[capacity]);
+            }
+        }
+        size = plain.getString(str, 6);
+        assert(plain.size() == size);
+        assert(0 == strcmp("plain", str));
+        (void)plain;
+        (void)newline;
+        (void)expected;
+        (void)size;
+    }
+}
+
 int main(void)
 {
+    test_reserve();
+    test_layout();
+    test_index();
+    test_utf8();
+    test_number();
+    test_find();
+    test_at();
+    test_stream();
+#ifndef CPPJSON_NO_THREADS
+    test_lines();
+#endif // CPPJSON_NO_THREADS
+#ifndef CPPJSON_NO_THREADS
+    test_parallel();
+#endif // CPPJSON_NO_THREADS
+    test_file();
+    test_cursor();
+    test_query();
+    test_projection();
+#ifndef CPPJSON_NO_BIND
+    test_bind();
+#endif // CPPJSON_NO_BIND
+    test_writer();
+    test_format();
+    test_saved_index();
+    test_nesting();
+    test_allocator();
+#ifndef CPPJSON_NO_THREADS
+    test_reader_pool();
+#endif // CPPJSON_NO_THREADS
+    test_validate();
+    test_events();
+    test_unescape();
     std::vector<File> files;
     gather(files, "../JSONTestSuite/test_parsing/", "*.json");
     test(files);